@@ -0,0 +1,150 @@
+// bench_library: memory taken by a large USB library in the playlist, as a
+// std::vector<TrackInfo> (how the playlist used to be kept) and as a
+// TrackStore, and the time for one pass over a shuffled play order.
+//
+// Usage: bench_library [tracks]   (default 100000)
+//
+// The library is synthetic but shaped like a real stick: artist/album
+// folders, a dozen tracks per album, and artists and folder names that
+// repeat across tracks. Each layout is built in a forked child so the
+// RSS growth of one does not include what the other left in the heap.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TrackInfo.h"
+#include "TrackStore.h"
+
+static const size_t TRACKS_PER_ALBUM = 12;
+static const size_t ALBUMS_PER_ARTIST = 4;
+
+// Resident set size in bytes, from /proc/self/statm.
+static size_t residentBytes()
+{
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0;
+    unsigned long pages = 0;
+    unsigned long resident = 0;
+    if (fscanf(file, "%lu %lu", &pages, &resident) != 2)
+        resident = 0;
+    fclose(file);
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Fills 'track' with the n'th synthetic track.
+static void makeTrack(size_t n, TrackInfo& track)
+{
+    size_t album = n / TRACKS_PER_ALBUM;
+    size_t artist = album / ALBUMS_PER_ARTIST;
+    char artistName[48];
+    char albumName[48];
+    char title[64];
+    snprintf(artistName, sizeof(artistName), "Artist Number %zu", artist);
+    snprintf(albumName, sizeof(albumName), "Album Title %zu", album);
+    snprintf(title, sizeof(title), "Track Title Of Moderate Length %zu", n);
+    track.filePath = std::string("/media/pi/Mustick/") + artistName + "/" + albumName + "/" +
+                     std::to_string(n % TRACKS_PER_ALBUM + 1) + " - " + title + ".mp3";
+    track.artist = artistName;
+    track.title = title;
+    track.duration = 180.0f + static_cast<float>(n % 120);
+    track.loudness = 0.0f;
+    track.mtime = 1700000000000000000LL + static_cast<long long>(n);
+    track.size = 5000000 + static_cast<long long>(n);
+}
+
+// Times one pass over the playlist, reading what the UI reads per track.
+static double walk(const std::vector<uint32_t>& order, const std::function<float(uint32_t)>& duration)
+{
+    auto start = std::chrono::steady_clock::now();
+    double total = 0.0;
+    for (uint32_t index : order)
+        total += duration(index);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (total < 0.0)
+        printf("unreachable\n");
+    return seconds;
+}
+
+static void report(const char* name, size_t count, size_t before, size_t after, double walkSeconds)
+{
+    double megabytes = (after - before) / (1024.0 * 1024.0);
+    printf("%-20s %8.1f MB %8.1f bytes/track   walk %6.2f ms\n", name, megabytes,
+           static_cast<double>(after - before) / count, walkSeconds * 1000.0);
+}
+
+static std::vector<uint32_t> shuffledOrder(size_t count)
+{
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; i++)
+        order[i] = static_cast<uint32_t>(i);
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+    return order;
+}
+
+static void benchVector(size_t count)
+{
+    std::vector<uint32_t> order = shuffledOrder(count);
+    size_t before = residentBytes();
+    std::vector<TrackInfo> playlist;
+    TrackInfo track;
+    for (size_t n = 0; n < count; n++) {
+        makeTrack(n, track);
+        playlist.push_back(track);
+    }
+    size_t after = residentBytes();
+    double seconds = walk(order, [&playlist](uint32_t i) { return playlist[i].duration; });
+    report("vector<TrackInfo>", count, before, after, seconds);
+}
+
+static void benchStore(size_t count)
+{
+    std::vector<uint32_t> order = shuffledOrder(count);
+    size_t before = residentBytes();
+    TrackStore library;
+    TrackInfo track;
+    for (size_t n = 0; n < count; n++) {
+        makeTrack(n, track);
+        library.Add(track);
+    }
+    size_t after = residentBytes();
+    double seconds = walk(order, [&library](uint32_t i) { return library.Get(i).duration; });
+    report("TrackStore", count, before, after, seconds);
+    printf("%-20s %8.1f MB by its own count\n", "", library.GetMemoryUsage() / (1024.0 * 1024.0));
+}
+
+static bool runInChild(void (*bench)(size_t), size_t count)
+{
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0)
+        return false;
+    if (child == 0) {
+        bench(count);
+        fflush(stdout);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    long count = (argc > 1) ? atol(argv[1]) : 100000;
+    if (count <= 0)
+        count = 100000;
+    printf("%ld tracks\n", count);
+    if (!runInChild(benchVector, static_cast<size_t>(count)) ||
+        !runInChild(benchStore, static_cast<size_t>(count)))
+        return 1;
+    return 0;
+}
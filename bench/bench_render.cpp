@@ -0,0 +1,404 @@
+// bench_render: drives the head unit's render path for N frames against an
+// offscreen GL context and reports frame-time percentiles and vertex/index
+// counts, so render-cost regressions show up on any Linux box.
+//
+// Usage: bench_render [frames] [width height]
+//
+// SDL_VIDEODRIVER defaults to "offscreen"; set LIBGL_ALWAYS_SOFTWARE=1 to
+// force Mesa llvmpipe on machines that have a GPU driver installed.
+// RADI0_INTERNAL_SCALE / RADI0_INTERNAL_FILTER select the internal-resolution
+// mode exactly as they do for the head unit.
+//
+// Heap allocations (operator new and ImGui's allocator) are counted per frame.
+// Once the script has gone through one full cycle, a frame without a track
+// change must not allocate at all; otherwise the benchmark exits with 1.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include "imgui.h"
+#include "imgui_impl_sdl2.h"
+#include "imgui_impl_opengl3.h"
+
+#include "IAudioManager.h"
+#include "Sprite.h"
+#include "UI.h"
+#include "Compositor.h"
+#include "ExhaustEffect.h"
+#include "FrameProfiler.h"
+#include "Upscaler.h"
+
+static const float VIRTUAL_WIDTH = 80.0f;
+static const float VIRTUAL_HEIGHT = 25.0f;
+static const float FRAME_DT = 1.0f / 60.0f;
+static const int WARMUP_FRAMES = 10;
+static const int SCRIPT_CYCLE = 300;
+
+// Allocation counting. Only allocations made while 'countAllocations' is set
+// are counted, so SDL/GL setup does not show up.
+static std::atomic<bool> countAllocations(false);
+static std::atomic<long long> allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    free(ptr);
+}
+
+static void* CountingImGuiAlloc(size_t size, void*)
+{
+    if (countAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size);
+}
+
+static void CountingImGuiFree(void* ptr, void*)
+{
+    free(ptr);
+}
+
+// Scripted stand-in for the USB/Bluetooth managers: a fixed-length playlist
+// with long names (so the marquee scrolls), advancing playback and a volume
+// sweep that moves the sun/moon through its whole path.
+class FakeAudioManager : public IAudioManager {
+public:
+    FakeAudioManager()
+        : state(PlaybackState::Stopped), volume(20), position(0.0f), track(0), version(NextPlaybackVersion()) {}
+
+    virtual bool Initialize() override { return true; }
+    virtual void Shutdown() override {}
+
+    virtual void Play() override { state = PlaybackState::Playing; position = 0.0f; }
+    virtual void Pause() override { if (state == PlaybackState::Playing) state = PlaybackState::Paused; }
+    virtual void Resume() override { if (state == PlaybackState::Paused) state = PlaybackState::Playing; }
+    virtual void NextTrack() override { SetTrack((track + 1) % TRACK_COUNT); }
+    virtual void PreviousTrack() override { SetTrack((track + TRACK_COUNT - 1) % TRACK_COUNT); }
+
+    virtual void SetVolume(int vol) override { volume = std::clamp(vol, 0, 128); }
+    virtual int GetVolume() const override { return volume; }
+
+    virtual PlaybackState GetState() const override { return state; }
+
+    virtual void Update(float delta_time) override {
+        if (state != PlaybackState::Playing)
+            return;
+        position += delta_time;
+        if (position >= GetCurrentTrackDuration())
+            NextTrack();
+    }
+
+    virtual float GetPlaybackFraction() const override { return position / GetCurrentTrackDuration(); }
+    virtual std::string GetTimeRemaining() const override {
+        int remaining = static_cast<int>(GetCurrentTrackDuration() - position);
+        char buffer[8];
+        snprintf(buffer, sizeof(buffer), "%02d:%02d", remaining / 60, remaining % 60);
+        return std::string(buffer);
+    }
+
+    virtual std::string GetCurrentTrackTitle() const override { return TRACKS[track].title; }
+    virtual std::string GetCurrentTrackArtist() const override { return TRACKS[track].artist; }
+    virtual float GetCurrentTrackDuration() const override { return TRACKS[track].duration; }
+    virtual float GetCurrentPlaybackPosition() const override { return position; }
+    virtual unsigned long long GetMetadataVersion() const override { return version; }
+
+private:
+    void SetTrack(int index) { track = index; version = NextPlaybackVersion(); Play(); }
+
+    struct Track { const char* artist; const char* title; float duration; };
+    static const int TRACK_COUNT = 3;
+    static const Track TRACKS[TRACK_COUNT];
+
+    PlaybackState state;
+    int volume;
+    float position;
+    int track;
+    unsigned long long version;
+};
+
+const FakeAudioManager::Track FakeAudioManager::TRACKS[FakeAudioManager::TRACK_COUNT] = {
+    { "Tigers Jaw", "Do You Really Wanna Know", 20.0f },
+    { "A Very Long Artist Name That Has To Scroll", "Short", 15.0f },
+    { "Band", "An Equally Long Track Title That Will Not Fit Either", 25.0f },
+};
+
+struct CountStats {
+    long long total = 0;
+    int min = 0;
+    int max = 0;
+
+    void Add(int value, bool first) {
+        total += value;
+        min = first ? value : std::min(min, value);
+        max = first ? value : std::max(max, value);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    int frames = (argc > 1) ? atoi(argv[1]) : 1000;
+    int window_width = (argc > 3) ? atoi(argv[2]) : 1280;
+    int window_height = (argc > 3) ? atoi(argv[3]) : 400;
+    if (frames <= 0 || window_width <= 0 || window_height <= 0) {
+        printf("Usage: %s [frames] [width height]\n", argv[0]);
+        return -1;
+    }
+
+    SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0)
+    {
+        printf("Error: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    const char* glsl_version = "#version 130";
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+
+    SDL_Window* window = SDL_CreateWindow("bench_render",
+                                          SDL_WINDOWPOS_UNDEFINED,
+                                          SDL_WINDOWPOS_UNDEFINED,
+                                          window_width, window_height,
+                                          SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (!window)
+    {
+        printf("Error: SDL_CreateWindow(): %s\n", SDL_GetError());
+        SDL_Quit();
+        return -1;
+    }
+    SDL_GLContext gl_context = SDL_GL_CreateContext(window);
+    if (!gl_context)
+    {
+        printf("Error: SDL_GL_CreateContext(): %s\n", SDL_GetError());
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return -1;
+    }
+    SDL_GL_MakeCurrent(window, gl_context);
+    SDL_GL_SetSwapInterval(0);
+
+    float scale = std::min(static_cast<float>(window_width) / VIRTUAL_WIDTH,
+                           static_cast<float>(window_height) / VIRTUAL_HEIGHT);
+    float offset_x = (window_width - VIRTUAL_WIDTH * scale) * 0.5f;
+    float offset_y = (window_height - VIRTUAL_HEIGHT * scale) * 0.5f;
+
+    IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(CountingImGuiAlloc, CountingImGuiFree);
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.Fonts->AddFontDefault();
+    ImGui::StyleColorsDark();
+    ImGuiStyle& style = ImGui::GetStyle();
+    style.WindowRounding = 0.0f;
+    style.WindowPadding = ImVec2(0, 0);
+    style.Colors[ImGuiCol_WindowBg] = ImVec4(0, 0, 0, 1);
+    ImVec4 newColor = ImVec4(109/255.f, 254/255.f, 149/255.f, 1.0f);
+    style.Colors[ImGuiCol_Text] = newColor;
+    style.Colors[ImGuiCol_Border] = newColor;
+
+    ImGui_ImplSDL2_InitForOpenGL(window, gl_context);
+    ImGui_ImplOpenGL3_Init(glsl_version);
+
+    int render_width = window_width;
+    int render_height = window_height;
+    Upscaler upscaler;
+    const char* internal_scale = getenv("RADI0_INTERNAL_SCALE");
+    int grid_multiple = internal_scale ? atoi(internal_scale) : 0;
+    if (grid_multiple > 0) {
+        const char* filter = getenv("RADI0_INTERNAL_FILTER");
+        bool linear = (filter && strcmp(filter, "linear") == 0);
+        if (upscaler.Initialize(static_cast<int>(VIRTUAL_WIDTH) * grid_multiple,
+                                static_cast<int>(VIRTUAL_HEIGHT) * grid_multiple, linear)) {
+            render_width = upscaler.GetWidth();
+            render_height = upscaler.GetHeight();
+            scale = static_cast<float>(grid_multiple);
+            offset_x = 0.0f;
+            offset_y = 0.0f;
+        }
+    }
+
+    printf("bench_render: %d frame(s) at %dx%d (internal %dx%d), GL renderer: %s\n",
+           frames, window_width, window_height, render_width, render_height,
+           (const char*)glGetString(GL_RENDERER));
+
+    FakeAudioManager audioManager;
+    audioManager.SetVolume(20);
+    audioManager.Play();
+    PlaybackSnapshot playback;
+
+    Sprite sprite;
+    sprite.Initialize(scale);
+    UI ui;
+    ui.Initialize();
+    ExhaustEffect exhaustEffect;
+    Compositor compositor;
+    FrameProfiler profiler;
+
+    CountStats vertices, indices, commands, allocations;
+    int steadyFrames = 0;
+    int allocatingFrames = 0;
+    for (int frame = 0; frame < WARMUP_FRAMES + frames; ++frame)
+    {
+        bool measured = frame >= WARMUP_FRAMES;
+        int script_frame = frame - WARMUP_FRAMES;
+
+        // Script: sweep the volume, and pause/resume periodically so the
+        // exhaust puff is part of the measured workload.
+        if (script_frame % 4 == 0)
+            audioManager.SetVolume((script_frame / 4) % 129);
+        if (script_frame % 300 == 150)
+            audioManager.Pause();
+        if (script_frame % 300 == 160) {
+            audioManager.Resume();
+            exhaustEffect.Trigger(sprite.GetExhaustPosition());
+        }
+
+        allocationCount.store(0);
+        countAllocations.store(measured);
+        unsigned long long lastVersion = playback.version;
+
+        profiler.BeginFrame();
+        profiler.BeginPhase(FramePhase::AudioUpdate);
+        audioManager.Update(FRAME_DT);
+        audioManager.GetSnapshot(playback);
+        profiler.EndPhase(FramePhase::AudioUpdate);
+
+        profiler.BeginPhase(FramePhase::NewFrame);
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplSDL2_NewFrame();
+        io.DeltaTime = FRAME_DT;   // Deterministic animation regardless of speed.
+        if (upscaler.IsEnabled()) {
+            io.DisplaySize = ImVec2(static_cast<float>(render_width), static_cast<float>(render_height));
+            io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
+        }
+        ImGui::NewFrame();
+        profiler.EndPhase(FramePhase::NewFrame);
+
+        // Same composition as main.cpp.
+        ImGuiWindowFlags wf = ImGuiWindowFlags_NoResize |
+                              ImGuiWindowFlags_NoMove |
+                              ImGuiWindowFlags_NoTitleBar |
+                              ImGuiWindowFlags_NoScrollbar |
+                              ImGuiWindowFlags_NoScrollWithMouse;
+        ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f);
+        ImGui::SetNextWindowPos(ImVec2(0, 0));
+        ImGui::SetNextWindowSize(ImVec2(static_cast<float>(render_width), static_cast<float>(render_height)));
+        ImGui::Begin("Car Head Unit", nullptr, wf);
+        compositor.Begin(ImGui::GetWindowDrawList());
+        {
+            ScopedPhase phase(profiler, FramePhase::UIRender);
+            ui.Render(compositor, playback, sprite, FRAME_DT, scale, offset_x, offset_y, render_width, render_height);
+        }
+
+        // The exhaust has its own layer between the text and the frame.
+        profiler.BeginPhase(FramePhase::Exhaust);
+        exhaustEffect.Update(FRAME_DT);
+        exhaustEffect.Draw(compositor.Layer(DrawLayer::Exhaust));
+        profiler.EndPhase(FramePhase::Exhaust);
+        compositor.End();
+        ImGui::End();
+        ImGui::PopStyleVar();
+
+        profiler.BeginPhase(FramePhase::ImGuiRender);
+        ImGui::Render();
+        profiler.EndPhase(FramePhase::ImGuiRender);
+
+        profiler.BeginPhase(FramePhase::RenderDrawData);
+        if (upscaler.IsEnabled())
+            upscaler.BeginFrame();
+        else
+            glViewport(0, 0, window_width, window_height);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (upscaler.IsEnabled())
+            upscaler.Present(window_width, window_height);
+        profiler.EndPhase(FramePhase::RenderDrawData);
+
+        // glFinish() so the GPU (or llvmpipe) work is charged to this frame.
+        profiler.BeginPhase(FramePhase::SwapWindow);
+        SDL_GL_SwapWindow(window);
+        glFinish();
+        profiler.EndPhase(FramePhase::SwapWindow);
+
+        countAllocations.store(false);
+        if (!measured)
+            continue;
+        profiler.EndFrame();
+
+        long long frameAllocations = allocationCount.load();
+        if (script_frame >= SCRIPT_CYCLE && playback.version == lastVersion) {
+            steadyFrames++;
+            if (frameAllocations > 0)
+                allocatingFrames++;
+        }
+
+        ImDrawData* draw_data = ImGui::GetDrawData();
+        int cmd_count = 0;
+        for (int n = 0; n < draw_data->CmdListsCount; n++)
+            cmd_count += draw_data->CmdLists[n]->CmdBuffer.Size;
+        bool first = (script_frame == 0);
+        vertices.Add(draw_data->TotalVtxCount, first);
+        indices.Add(draw_data->TotalIdxCount, first);
+        commands.Add(cmd_count, first);
+        allocations.Add(static_cast<int>(frameAllocations), first);
+    }
+
+    printf("\n%-18s %9s %9s %9s %9s\n", "phase (ms)", "p50", "p95", "p99", "max");
+    for (size_t i = 0; i < FrameProfiler::PHASE_COUNT; ++i) {
+        FramePhase phase = static_cast<FramePhase>(i);
+        if (phase == FramePhase::EventPoll)
+            continue;   // No event loop in the benchmark.
+        FrameProfiler::PhaseStats stats = profiler.ComputeStats(phase);
+        printf("%-18s %9.3f %9.3f %9.3f %9.3f\n", FrameProfiler::GetPhaseName(phase),
+               stats.p50, stats.p95, stats.p99, stats.max);
+    }
+    printf("(percentiles over the last %zu frame(s))\n\n", profiler.GetSampleCount());
+
+    printf("%-18s %9s %9s %9s\n", "per frame", "min", "avg", "max");
+    printf("%-18s %9d %9.1f %9d\n", "vertices", vertices.min, static_cast<double>(vertices.total) / frames, vertices.max);
+    printf("%-18s %9d %9.1f %9d\n", "indices", indices.min, static_cast<double>(indices.total) / frames, indices.max);
+    printf("%-18s %9d %9.1f %9d\n", "draw commands", commands.min, static_cast<double>(commands.total) / frames, commands.max);
+    printf("%-18s %9d %9.1f %9d\n", "heap allocations", allocations.min, static_cast<double>(allocations.total) / frames, allocations.max);
+    printf("\nsteady state: %d of %d frame(s) allocated\n", allocatingFrames, steadyFrames);
+
+    ui.Cleanup();
+    sprite.Cleanup();
+    upscaler.Cleanup();
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplSDL2_Shutdown();
+    ImGui::DestroyContext();
+
+    SDL_GL_DeleteContext(gl_context);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+
+    return (allocatingFrames > 0) ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+// bench_resample: measures what SDL's own sample-rate conversion costs on
+// this CPU, as CPU% of one core per stereo stream. It is the same
+// converter SDL_mixer runs when a track's rate differs from the output rate
+// that USBAudioManager negotiated, so it tells whether 44.1 kHz files on a
+// 48 kHz DAC (or the reverse) are worth worrying about.
+//
+// Usage: bench_resample [seconds of audio per case]
+//
+// Each case pushes a synthetic S16 stereo signal through an SDL_AudioStream
+// in 4096-frame periods, as the mixer does, and pulls the converted output.
+// Equal-rate cases show the floor: the copy that happens anyway.
+
+#include <SDL.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+struct Case {
+    int inRate;
+    int outRate;
+};
+
+static const Case CASES[] = {
+    { 44100, 44100 },
+    { 48000, 48000 },
+    { 44100, 48000 },
+    { 48000, 44100 },
+    { 22050, 48000 },
+};
+
+static const int PERIOD_FRAMES = 4096;
+
+// Process CPU time, so a busy desktop does not inflate the numbers.
+static double cpuSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static bool runCase(const Case& c, double seconds, double& cpuPercent)
+{
+    SDL_AudioStream* stream = SDL_NewAudioStream(AUDIO_S16SYS, 2, c.inRate, AUDIO_S16SYS, 2, c.outRate);
+    if (!stream) {
+        fprintf(stderr, "SDL_NewAudioStream failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // One period of a 440 Hz tone; the signal itself does not matter much.
+    std::vector<Sint16> period(PERIOD_FRAMES * 2);
+    for (int i = 0; i < PERIOD_FRAMES; i++) {
+        Sint16 value = static_cast<Sint16>(12000.0 * sin(2.0 * M_PI * 440.0 * i / c.inRate));
+        period[i * 2] = value;
+        period[i * 2 + 1] = value;
+    }
+    std::vector<Sint16> out(PERIOD_FRAMES * 2 * 8);
+
+    long periods = static_cast<long>(seconds * c.inRate / PERIOD_FRAMES);
+    double start = cpuSeconds();
+    for (long p = 0; p < periods; p++) {
+        if (SDL_AudioStreamPut(stream, period.data(), static_cast<int>(period.size() * sizeof(Sint16))) < 0)
+            break;
+        while (SDL_AudioStreamGet(stream, out.data(), static_cast<int>(out.size() * sizeof(Sint16))) > 0) {
+        }
+    }
+    double elapsed = cpuSeconds() - start;
+    SDL_FreeAudioStream(stream);
+
+    double audioSeconds = static_cast<double>(periods) * PERIOD_FRAMES / c.inRate;
+    cpuPercent = (audioSeconds > 0.0) ? 100.0 * elapsed / audioSeconds : 0.0;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 600.0;
+    if (seconds <= 0.0)
+        seconds = 600.0;
+
+    printf("%-16s %10s\n", "conversion", "cpu/stream");
+    for (const Case& c : CASES) {
+        double cpuPercent = 0.0;
+        if (!runCase(c, seconds, cpuPercent))
+            return 1;
+        printf("%5d -> %5d Hz %9.3f%%\n", c.inRate, c.outRate, cpuPercent);
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+// bench_underrun: checks that late mixer periods are detected. It plays
+// through SDL's dummy audio driver, which paces callbacks like a real
+// device, with a stand-in decoder that stalls for a few periods every so
+// often, as a slow decode off a USB stick would. MixMonitor, hooked in
+// after the mix exactly as USBAudioManager hooks it, must count each stall
+// as a late period; a second run without stalls shows the baseline.
+//
+// Usage: bench_underrun [seconds per run]
+//
+// Exits non-zero if the stalled run reports no late period.
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MixMonitor.h"
+
+static const int PERIOD_FRAMES = 1024;
+static const int STALL_EVERY = 20;    // Periods between stalls
+static const int STALL_PERIODS = 4;   // Length of a stall
+
+struct Decoder {
+    int calls;
+    Uint32 stallMs;   // 0: never stalls
+};
+
+// Music hook standing in for the decoder: silence, late now and then.
+static void decode(void* udata, Uint8* stream, int length)
+{
+    Decoder* decoder = static_cast<Decoder*>(udata);
+    memset(stream, 0, length);
+    if (decoder->stallMs > 0 && ++decoder->calls % STALL_EVERY == 0)
+        SDL_Delay(decoder->stallMs);
+}
+
+static void postMix(void* udata, Uint8* /*stream*/, int length)
+{
+    static_cast<MixMonitor*>(udata)->OnMixed(length);
+}
+
+// Plays for 'seconds' and returns the late periods counted.
+static unsigned long long run(double bytesPerSecond, Uint32 stallMs, double seconds)
+{
+    Decoder decoder = { 0, stallMs };
+    MixMonitor monitor;
+    monitor.Start(bytesPerSecond);
+    Mix_SetPostMix(postMix, &monitor);
+    Mix_HookMusic(decode, &decoder);
+    SDL_Delay(static_cast<Uint32>(seconds * 1000.0));
+    Mix_HookMusic(nullptr, nullptr);
+    Mix_SetPostMix(nullptr, nullptr);
+
+    double time = 0.0;
+    float lateMs = 0.0f;
+    float worstMs = 0.0f;
+    while (monitor.PollUnderrun(time, lateMs)) {
+        if (lateMs > worstMs)
+            worstMs = lateMs;
+    }
+    printf("stall %4u ms: %llu period(s) mixed, %llu late (worst %.1f ms)\n",
+           stallMs, monitor.GetMixedPeriods(), monitor.GetLatePeriods(), worstMs);
+    return monitor.GetLatePeriods();
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 3.0;
+    if (seconds <= 0.0)
+        seconds = 3.0;
+
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    if (Mix_OpenAudio(48000, AUDIO_S16SYS, 2, PERIOD_FRAMES) < 0) {
+        fprintf(stderr, "Mix_OpenAudio failed: %s\n", Mix_GetError());
+        SDL_Quit();
+        return 1;
+    }
+    int frequency = 0;
+    Uint16 format = 0;
+    int channels = 0;
+    Mix_QuerySpec(&frequency, &format, &channels);
+    double bytesPerSecond = static_cast<double>(frequency) * channels * (SDL_AUDIO_BITSIZE(format) / 8);
+    Uint32 periodMs = static_cast<Uint32>(1000.0 * PERIOD_FRAMES / frequency);
+
+    run(bytesPerSecond, 0, seconds);
+    unsigned long long late = run(bytesPerSecond, STALL_PERIODS * periodMs, seconds);
+
+    Mix_CloseAudio();
+    SDL_Quit();
+    if (late == 0) {
+        fprintf(stderr, "FAIL: stalled decoder produced no late periods\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <SDL.h>
 #include <sys/stat.h>
 #include <memory>
@@ -19,6 +21,12 @@
 #include "modules/Sprite.h"
 #include "modules/UI.h"
 #include "ExhaustEffect.h"    // NEW: Include our exhaust effect header
+#include "RenderScheduler.h"
+#include "FrameProfiler.h"
+#include "Upscaler.h"
+#include "Compositor.h"
+#include "MountWatcher.h"
+#include "LibraryBrowser.h"
 #include <algorithm>
 
 // Utility function to check if a directory exists.
@@ -38,6 +46,50 @@ static const float VIRTUAL_HEIGHT = 25.0f;
 // Global atomic flag to prevent overlapping mode switches.
 std::atomic<bool> switchInProgress(false);
 
+// Replaces the current manager with Bluetooth if a phone is paired. When
+// the USB stick is gone (usbRemoved), the USB manager is shut down first,
+// so nothing keeps reading from the vanished drive, and Bluetooth takes
+// over either way, waiting for a phone if none is paired.
+static bool switchToBluetooth(std::unique_ptr<IAudioManager>& audioManager, bool usbRemoved = false)
+{
+    if (usbRemoved)
+        audioManager->Shutdown();
+    auto tempBt = std::make_unique<BluetoothAudioManager>();
+    bool paired = tempBt->Initialize() && tempBt->IsPaired();
+    if (!paired && !usbRemoved) {
+        printf("No paired phone found. Remaining in USB mode.\n");
+        return false;
+    }
+    if (!paired)
+        printf("No paired phone found. Waiting for one in Bluetooth mode.\n");
+    if (!usbRemoved)
+        audioManager->Shutdown();
+    audioManager = std::move(tempBt);
+    currentAudioMode = BLUETOOTH_MODE;
+    printf("Switched to Bluetooth Audio Manager.\n");
+    audioManager->SetVolume(20);  // Set default low volume
+    audioManager->Play();
+    return true;
+}
+
+// Replaces the current manager with a fresh USB one.
+static bool switchToUSB(std::unique_ptr<IAudioManager>& audioManager)
+{
+    audioManager->Shutdown();
+    if (currentAudioMode == BLUETOOTH_MODE)
+        SDL_Delay(1500);
+    audioManager = std::make_unique<USBAudioManager>();
+    currentAudioMode = USB_MODE;
+    printf("Switched to USB Audio Manager.\n");
+    if (!audioManager->Initialize()) {
+        printf("Failed to reinitialize USB Audio Manager.\n");
+        return false;
+    }
+    audioManager->SetVolume(20);  // Set default low volume
+    audioManager->Play();
+    return true;
+}
+
 int main(int, char**)
 {
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0)
@@ -122,8 +174,35 @@ int main(int, char**)
     ImGui_ImplSDL2_InitForOpenGL(window, gl_context);
     ImGui_ImplOpenGL3_Init(glsl_version);
 
+    // Optional internal-resolution mode: RADI0_INTERNAL_SCALE=N renders the UI
+    // into an (N*80)x(N*25) target and scales it up to the window, so the fill
+    // cost is the same on every panel. RADI0_INTERNAL_FILTER=linear smooths the
+    // upscale (default: nearest).
+    int render_width = window_width;
+    int render_height = window_height;
+    Upscaler upscaler;
+    const char* internal_scale = getenv("RADI0_INTERNAL_SCALE");
+    int grid_multiple = internal_scale ? atoi(internal_scale) : 0;
+    if (grid_multiple > 0) {
+        const char* filter = getenv("RADI0_INTERNAL_FILTER");
+        bool linear = (filter && strcmp(filter, "linear") == 0);
+        if (upscaler.Initialize(static_cast<int>(VIRTUAL_WIDTH) * grid_multiple,
+                                static_cast<int>(VIRTUAL_HEIGHT) * grid_multiple, linear)) {
+            render_width = upscaler.GetWidth();
+            render_height = upscaler.GetHeight();
+            scale = static_cast<float>(grid_multiple);
+            offset_x = 0.0f;
+            offset_y = 0.0f;
+            printf("Rendering at %dx%d, upscaled to %dx%d (%s).\n", render_width, render_height,
+                   window_width, window_height, linear ? "linear" : "nearest");
+        } else {
+            printf("Internal resolution unavailable, rendering at %dx%d.\n", window_width, window_height);
+        }
+    }
+
     // Determine initial audio mode.
-    if (directoryExists("/media/jdx4444/Mustick"))
+    const std::string usbMountPath = USBAudioManager::GetMountPath();
+    if (directoryExists(usbMountPath.c_str()))
          currentAudioMode = USB_MODE;
     else
          currentAudioMode = BLUETOOTH_MODE;
@@ -144,6 +223,11 @@ int main(int, char**)
     audioManager->SetVolume(20); // Set default volume low
     audioManager->Play();
 
+    // Posts an event when the stick is plugged in or pulled.
+    MountWatcher mountWatcher;
+    if (!mountWatcher.Start(usbMountPath))
+        printf("USB hotplug detection unavailable.\n");
+
     Sprite sprite;
     sprite.Initialize(scale);
     UI ui;
@@ -151,18 +235,101 @@ int main(int, char**)
 
     // Create our exhaust effect instance.
     ExhaustEffect exhaustEffect;
+    // Layers everything in the single head unit window.
+    Compositor compositor;
+
+    // What the UI draws from the audio manager; refreshed on every wake-up.
+    PlaybackSnapshot playback;
+    AudioUnderrun underrun;
+
+    // TAB lists the USB library by artist and title, searchable by typing.
+    LibraryBrowser browser;
+    // audioManager when it is the USB one; refreshed after every switch.
+    USBAudioManager* usbManager = dynamic_cast<USBAudioManager*>(audioManager.get());
+
+    // Only build frames when something on screen can change.
+    RenderScheduler scheduler;
+    scheduler.Initialize(DM.refresh_rate);
+    const LayoutConfig& layout = ui.GetLayoutConfig();
+    scheduler.SetProgressResolution((layout.progressBarEndX - layout.progressBarStartX) * scale);
+
+    // Per-phase frame timings; 'p' or SIGUSR1 dumps percentiles to a file.
+    FrameProfiler profiler;
+    profiler.InstallSignalHandler();
 
     bool done = false;
     while (!done)
     {
         SDL_Event event;
-        while (SDL_PollEvent(&event))
+        // Sleeps until input arrives or the next wake-up is due.
+        bool pending = scheduler.WaitForEvent(event);
+        profiler.BeginFrame();
+        profiler.BeginPhase(FramePhase::EventPoll);
+        for (; pending; pending = SDL_PollEvent(&event))
         {
             ImGui_ImplSDL2_ProcessEvent(&event);
             if (event.type == SDL_QUIT)
                 done = true;
             if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE)
                 done = true;
+            if (mountWatcher.GetEventType() != 0 && event.type == mountWatcher.GetEventType() &&
+                !switchInProgress.load())
+            {
+                switchInProgress.store(true);
+                // A USB start-up already under way is left alone; a stopped
+                // or failed one is restarted.
+                bool usbRunning = currentAudioMode == USB_MODE && usbManager &&
+                                  usbManager->GetInitStage() != UsbInitStage::Failed;
+                if (event.user.code == MountWatcher::Unmounted && currentAudioMode == USB_MODE) {
+                    printf("USB drive removed.\n");
+                    switchToBluetooth(audioManager, true);
+                } else if (event.user.code == MountWatcher::Mounted && !usbRunning) {
+                    printf("USB drive inserted.\n");
+                    switchToUSB(audioManager);
+                }
+                usbManager = dynamic_cast<USBAudioManager*>(audioManager.get());
+                switchInProgress.store(false);
+            }
+            if (event.type == SDL_TEXTINPUT && browser.IsOpen())
+                browser.Type(event.text.text);
+            if (event.type == SDL_KEYDOWN && browser.IsOpen())
+            {
+                // While browsing, keys drive the list; text arrives as
+                // SDL_TEXTINPUT.
+                switch (event.key.keysym.sym) {
+                    case SDLK_ESCAPE:
+                    case SDLK_TAB:
+                        browser.Close();
+                        SDL_StopTextInput();
+                        break;
+                    case SDLK_UP:
+                        browser.MoveSelection(-1);
+                        break;
+                    case SDLK_DOWN:
+                        browser.MoveSelection(1);
+                        break;
+                    case SDLK_PAGEUP:
+                        browser.MoveSelection(-browser.GetPageRows());
+                        break;
+                    case SDLK_PAGEDOWN:
+                        browser.MoveSelection(browser.GetPageRows());
+                        break;
+                    case SDLK_BACKSPACE:
+                        browser.Erase();
+                        break;
+                    case SDLK_RETURN: {
+                        uint32_t track = 0;
+                        if (usbManager && browser.GetSelectedTrack(track) && usbManager->PlayTrack(track)) {
+                            browser.Close();
+                            SDL_StopTextInput();
+                        }
+                        break;
+                    }
+                    default:
+                        break;
+                }
+                continue;
+            }
             if (event.type == SDL_KEYDOWN)
             {
                 SDL_Keycode key = event.key.keysym.sym;
@@ -176,34 +343,15 @@ int main(int, char**)
                         case SDLK_e:
                         switchInProgress.store(true);
                         if (currentAudioMode == USB_MODE) {
-                            auto tempBt = std::make_unique<BluetoothAudioManager>();
-                            if (!tempBt->Initialize() || !tempBt->IsPaired()) {
-                                printf("No paired phone found. Remaining in USB mode.\n");
-                            } else {
-                                audioManager->Shutdown();
-                                audioManager = std::move(tempBt);
-                                currentAudioMode = BLUETOOTH_MODE;
-                                printf("Switched to Bluetooth Audio Manager.\n");
-                                audioManager->SetVolume(20);  // Set default low volume
-                                audioManager->Play();
-                            }
+                            switchToBluetooth(audioManager);
                         } else { // currentAudioMode == BLUETOOTH_MODE
-                            if (directoryExists("/media/jdx4444/Mustick")) {
-                                audioManager->Shutdown();
-                                SDL_Delay(1500);
-                                audioManager = std::make_unique<USBAudioManager>();
-                                currentAudioMode = USB_MODE;
-                                printf("Switched to USB Audio Manager.\n");
-                                if (!audioManager->Initialize()) {
-                                    printf("Failed to reinitialize USB Audio Manager.\n");
-                                } else {
-                                    audioManager->SetVolume(20);  // Set default low volume
-                                    audioManager->Play();
-                                }
+                            if (directoryExists(usbMountPath.c_str())) {
+                                switchToUSB(audioManager);
                             } else {
                                 printf("USB drive not available. Remaining in Bluetooth mode.\n");
                             }
                         }
+                        usbManager = dynamic_cast<USBAudioManager*>(audioManager.get());
                         switchInProgress.store(false);
                         break;
                     case SDLK_SPACE:
@@ -229,17 +377,58 @@ int main(int, char**)
                     case SDLK_DOWN:
                         audioManager->SetVolume(audioManager->GetVolume() - 8);
                         break;
+                    case SDLK_p:
+                        profiler.RequestDump();
+                        break;
+                    case SDLK_TAB:
+                        browser.Open();
+                        if (browser.IsOpen())
+                            SDL_StartTextInput();
+                        break;
                     default:
                         break;
                 }
             }
         }
+        profiler.EndPhase(FramePhase::EventPoll);
+
+        if (profiler.ConsumeDumpRequest())
+            profiler.Dump();
+
+        // The audio manager is updated on every wake-up, rendered or not,
+        // so it gets its own delta instead of io.DeltaTime.
+        profiler.BeginPhase(FramePhase::AudioUpdate);
+        audioManager->Update(scheduler.Tick());
+        audioManager->GetSnapshot(playback);
+        while (audioManager->PollUnderrun(underrun))
+            profiler.RecordAudioUnderrun(underrun.time, underrun.lateMs, underrun.track);
+        {
+            // Lets the browser know when the library changes; while open it
+            // rebuilds its search index in the background.
+            bool wasOpen = browser.IsOpen();
+            if (browser.SetLibrary(usbManager ? usbManager->GetLibrary() : nullptr,
+                                   usbManager ? usbManager->GetLibraryVersion() : 0))
+                scheduler.RequestFrame();
+            if (wasOpen && !browser.IsOpen())
+                SDL_StopTextInput();
+        }
+        profiler.EndPhase(FramePhase::AudioUpdate);
+        scheduler.ObserveAudio(playback);
+        if (!scheduler.ShouldRender())
+            continue;
 
+        profiler.BeginPhase(FramePhase::NewFrame);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplSDL2_NewFrame();
+        if (upscaler.IsEnabled()) {
+            // The backend reports the window size; lay out at the internal size.
+            io.DisplaySize = ImVec2(static_cast<float>(render_width), static_cast<float>(render_height));
+            io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
+        }
         ImGui::NewFrame();
-
-        audioManager->Update(io.DeltaTime);
+        profiler.EndPhase(FramePhase::NewFrame);
+        // Not io.DeltaTime, which spans any idle time before this frame.
+        float animationDelta = scheduler.AnimationDelta();
 
         // Draw main UI window without borders.
         ImGuiWindowFlags wf = ImGuiWindowFlags_NoResize |
@@ -249,43 +438,66 @@ int main(int, char**)
                               ImGuiWindowFlags_NoScrollWithMouse;
         ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f); // Remove default border
         ImGui::SetNextWindowPos(ImVec2(0, 0));
-        ImGui::SetNextWindowSize(ImVec2(static_cast<float>(window_width), static_cast<float>(window_height)));
+        ImGui::SetNextWindowSize(ImVec2(static_cast<float>(render_width), static_cast<float>(render_height)));
         ImGui::Begin("Car Head Unit", nullptr, wf);
-        {
-            ImDrawList* draw_list = ImGui::GetWindowDrawList();
-            ui.Render(draw_list, *audioManager, sprite, scale, offset_x, offset_y, window_width, window_height);
+        compositor.Begin(ImGui::GetWindowDrawList());
+        if (!browser.IsOpen()) {
+            {
+                ScopedPhase phase(profiler, FramePhase::UIRender);
+                ui.Render(compositor, playback, sprite, animationDelta, scale, offset_x, offset_y, render_width, render_height);
+            }
+
+            // The exhaust has its own layer between the text and the frame.
+            profiler.BeginPhase(FramePhase::Exhaust);
+            exhaustEffect.Update(animationDelta);
+            exhaustEffect.Draw(compositor.Layer(DrawLayer::Exhaust));
+            profiler.EndPhase(FramePhase::Exhaust);
         }
+        compositor.End();
         ImGui::End();
         ImGui::PopStyleVar();
 
-        // Draw overlay window for exhaust effect, mask bars, borders, and status box.
-        ImGui::SetNextWindowPos(ImVec2(0, 0));
-        ImGui::SetNextWindowSize(ImVec2(static_cast<float>(window_width), static_cast<float>(window_height)));
-        ImGui::Begin("Exhaust & Mask Overlay", nullptr,
-                    ImGuiWindowFlags_NoTitleBar |
-                    ImGuiWindowFlags_NoResize |
-                    ImGuiWindowFlags_NoMove |
-                    ImGuiWindowFlags_NoScrollbar |
-                    ImGuiWindowFlags_NoInputs |
-                    ImGuiWindowFlags_NoBackground);
-        {
-            exhaustEffect.Update(io.DeltaTime);
-            ImDrawList* overlay_draw_list = ImGui::GetWindowDrawList();
-            exhaustEffect.Draw(overlay_draw_list);
-            ui.DrawMaskBars(overlay_draw_list, scale, offset_x, offset_y);
-            ui.DrawBorders(overlay_draw_list, window_width, window_height);
+        if (browser.IsOpen()) {
+            // Takes the place of the HUD, between the screen's borders.
+            ScopedPhase phase(profiler, FramePhase::UIRender);
+            browser.Draw(ImVec2(offset_x + layout.trackRegionLeftX * scale, offset_y + layout.borderPadding * scale),
+                         ImVec2((layout.trackRegionRightX - layout.trackRegionLeftX) * scale,
+                                (VIRTUAL_HEIGHT - 2.0f * layout.borderPadding) * scale));
         }
-        ImGui::End();
 
+        profiler.BeginPhase(FramePhase::ImGuiRender);
         ImGui::Render();
-        glViewport(0, 0, window_width, window_height);
+        profiler.EndPhase(FramePhase::ImGuiRender);
+
+        profiler.BeginPhase(FramePhase::RenderDrawData);
+        if (upscaler.IsEnabled())
+            upscaler.BeginFrame();
+        else
+            glViewport(0, 0, window_width, window_height);
         glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (upscaler.IsEnabled())
+            upscaler.Present(window_width, window_height);
+        profiler.EndPhase(FramePhase::RenderDrawData);
+
+        profiler.BeginPhase(FramePhase::SwapWindow);
         SDL_GL_SwapWindow(window);
+        profiler.EndPhase(FramePhase::SwapWindow);
+        profiler.EndFrame();
+
+        scheduler.FrameRendered();
+        // An open browser that is still indexing keeps the loop at the
+        // display rate so the index is ready sooner.
+        if (browser.IsOpen() ? browser.IsIndexing() : (ui.IsAnimating() || exhaustEffect.IsActive()))
+            scheduler.RequestAnimationFrame();
     }
 
+    mountWatcher.Stop();
+    scheduler.PrintStats();
     ui.Cleanup();
+    sprite.Cleanup();
+    upscaler.Cleanup();
     audioManager->Shutdown();
 
     ImGui_ImplOpenGL3_Shutdown();
@@ -1,10 +1,9 @@
 #include "BluetoothAudioManager.h"
 #include <iostream>
-#include <iomanip>
-#include <sstream>
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <cmath>
 #include <thread>
 #include <chrono>
 #include <cstdio>  // Added for popen and pclose
@@ -67,6 +66,7 @@ BluetoothAudioManager::BluetoothAudioManager()
       current_track_artist(""),
       current_track_duration(0.0f),
       playback_position(0.0f),
+      metadata_version(NextPlaybackVersion()),
       ignore_position_updates(false),
       time_since_last_dbus_position(0.0f),
       just_resumed(false),
@@ -345,10 +345,9 @@ std::string BluetoothAudioManager::GetTimeRemaining() const {
         remaining = 0.0f;
     int minutes = static_cast<int>(remaining) / 60;
     int seconds = static_cast<int>(remaining) % 60;
-    std::ostringstream oss;
-    oss << std::setw(2) << std::setfill('0') << minutes << ":"
-        << std::setw(2) << std::setfill('0') << seconds;
-    return oss.str();
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%02d:%02d", minutes, seconds);
+    return std::string(buffer);
 }
 
 // -----------------------------------------------------------------------------
@@ -508,6 +507,7 @@ void BluetoothAudioManager::HandlePropertiesChanged(DBusMessage* msg) {
                                 const char* title = nullptr;
                                 dbus_message_iter_get_basic(&inner_variant, &title);
                                 current_track_title = title ? title : "";
+                                metadata_version = NextPlaybackVersion();
                                 std::cout << "DEBUG: Updated Title: " << current_track_title << "\n";
                             }
                             else if ((strcmp(meta_key, "xesam:artist") == 0 || strcmp(meta_key, "Artist") == 0)) {
@@ -518,12 +518,14 @@ void BluetoothAudioManager::HandlePropertiesChanged(DBusMessage* msg) {
                                         const char* artist = nullptr;
                                         dbus_message_iter_get_basic(&artist_array, &artist);
                                         current_track_artist = artist ? artist : "";
+                                        metadata_version = NextPlaybackVersion();
                                         std::cout << "DEBUG: Updated Artist: " << current_track_artist << "\n";
                                     }
                                 } else if (basic_type == DBUS_TYPE_STRING) {
                                     const char* artist = nullptr;
                                     dbus_message_iter_get_basic(&inner_variant, &artist);
                                     current_track_artist = artist ? artist : "";
+                                    metadata_version = NextPlaybackVersion();
                                     std::cout << "DEBUG: Updated Artist: " << current_track_artist << "\n";
                                 }
                             }
@@ -534,11 +536,13 @@ void BluetoothAudioManager::HandlePropertiesChanged(DBusMessage* msg) {
                                     current_track_duration = (length_val < 1000000)
                                         ? static_cast<float>(length_val) / 1000.0f
                                         : static_cast<float>(length_val) / 1000000.0f;
+                                    metadata_version = NextPlaybackVersion();
                                     std::cout << "DEBUG: Updated Track Duration: " << current_track_duration << "s\n";
                                 } else if (basic_type == DBUS_TYPE_UINT32) {
                                     uint32_t length_val;
                                     dbus_message_iter_get_basic(&inner_variant, &length_val);
                                     current_track_duration = static_cast<float>(length_val) / 1000.0f;
+                                    metadata_version = NextPlaybackVersion();
                                     std::cout << "DEBUG: Updated Track Duration: " << current_track_duration << "s\n";
                                 }
                             }
@@ -804,3 +808,7 @@ float BluetoothAudioManager::GetCurrentTrackDuration() const {
 float BluetoothAudioManager::GetCurrentPlaybackPosition() const {
     return playback_position;
 }
+
+unsigned long long BluetoothAudioManager::GetMetadataVersion() const {
+    return metadata_version;
+}
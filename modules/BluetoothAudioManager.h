@@ -35,6 +35,7 @@ public:
     virtual std::string GetCurrentTrackArtist() const override;
     virtual float GetCurrentTrackDuration() const override;
     virtual float GetCurrentPlaybackPosition() const override;
+    virtual unsigned long long GetMetadataVersion() const override;
         
     // Inline method to check if a phone is paired (i.e. if MediaPlayer1 was found).
     bool IsPaired() const { return !current_player_path.empty(); }
@@ -47,6 +48,7 @@ private:
     std::string current_track_artist;
     float current_track_duration; // in seconds
     float playback_position;      // in seconds
+    unsigned long long metadata_version; // Bumped on title/artist/duration updates
     bool ignore_position_updates;
     float time_since_last_dbus_position;
     bool just_resumed;
@@ -0,0 +1,25 @@
+#include "Compositor.h"
+
+Compositor::Compositor()
+    : drawList(nullptr)
+{
+}
+
+void Compositor::Begin(ImDrawList* draw_list)
+{
+    drawList = draw_list;
+    // Channel 0 keeps what is already in the list (the window background).
+    splitter.Split(drawList, static_cast<int>(DrawLayer::Count));
+}
+
+ImDrawList* Compositor::Layer(DrawLayer layer)
+{
+    splitter.SetCurrentChannel(drawList, static_cast<int>(layer));
+    return drawList;
+}
+
+void Compositor::End()
+{
+    splitter.Merge(drawList);
+    drawList = nullptr;
+}
@@ -0,0 +1,34 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include "imgui.h"
+
+// Draw layers of the head unit, listed bottom to top.
+enum class DrawLayer {
+    Background, // Window background and the sun/moon.
+    Horizon,    // Sun mask and progress line (covers the sun).
+    Sprite,     // Car sprite, on top of the progress line.
+    Text,       // Artist and track marquee.
+    Exhaust,    // Exhaust particles.
+    Frame,      // Mask bars and borders on top of everything.
+    Count
+};
+
+// Lets everything be recorded into one window's draw list in any order while
+// keeping the visual stacking above: each layer is an ImDrawListSplitter
+// channel and the channels are merged bottom to top in End().
+class Compositor {
+public:
+    Compositor();
+
+    void Begin(ImDrawList* draw_list);
+    // Switches to the given layer and returns the draw list to record into.
+    ImDrawList* Layer(DrawLayer layer);
+    void End();
+
+private:
+    ImDrawListSplitter splitter;
+    ImDrawList* drawList;
+};
+
+#endif // COMPOSITOR_H
@@ -2,21 +2,28 @@
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
+
+// Build with -DRADI0_TRACE_EXHAUST to log particles. It is off by default so
+// a puff never stalls the render thread on a stdout flush.
+#ifdef RADI0_TRACE_EXHAUST
 #include <iostream>
+#define EXHAUST_TRACE(msg) (std::cout << "DEBUG: " << msg << "\n")
+#else
+#define EXHAUST_TRACE(msg) ((void)0)
+#endif
 
-ExhaustEffect::ExhaustEffect() {}
+ExhaustEffect::ExhaustEffect() : count(0) {}
 
 void ExhaustEffect::Trigger(const ImVec2& position) {
-    const int numParticles = 8; // Number of particles in the shot.
-    std::cout << "DEBUG: ExhaustEffect::Trigger - Emitting " 
-              << numParticles << " particles at position (" 
-              << position.x << ", " << position.y << ")." << std::endl;
+    const int numParticles = std::min(8, MAX_PARTICLES); // Number of particles in the shot.
+    EXHAUST_TRACE("ExhaustEffect::Trigger - Emitting " << numParticles
+                  << " particles at position (" << position.x << ", " << position.y << ").");
     
-    particles.clear();  // Start fresh.
+    count = 0;  // Start fresh.
     for (int i = 0; i < numParticles; ++i) {
-        Particle p;
         // All particles start at the given position.
-        p.position = position;
+        positionX[i] = position.x;
+        positionY[i] = position.y;
         
         // Instead of evenly spacing, we add a random offset to the central angle.
         // Central angle is 180° (leftward) in radians.
@@ -25,44 +32,59 @@ void ExhaustEffect::Trigger(const ImVec2& position) {
         float offsetDeg = (std::rand() % 41) - 20; // random integer in [-20, 20]
         float offsetRad = offsetDeg * 3.1415926f / 180.0f;
         float angle = centralAngle + offsetRad;
-        std::cout << "DEBUG: Particle " << i << " angle (deg): " << (angle * 180.0f / 3.1415926f) << std::endl;
+        EXHAUST_TRACE("Particle " << i << " angle (deg): " << (angle * 180.0f / 3.1415926f));
         
-        // Set speed: 5 to 10 pixels per second.
+        // Set speed: 14 to 19 pixels per second.
         float speed = 14.0f + (std::rand() % 6);
-        p.velocity = ImVec2(std::cos(angle) * speed, std::sin(angle) * speed);
-        
-        // Short lifetime: between 0.5 and 0.7 seconds.
-        p.initialLifetime = p.lifetime = 1.5f + (std::rand() % 21) / 100.0f;
+        velocityX[i] = std::cos(angle) * speed;
+        velocityY[i] = std::sin(angle) * speed;
         
-        particles.push_back(p);
+        // Lifetime: between 1.5 and 1.7 seconds.
+        initialLifetime[i] = lifetime[i] = 1.5f + (std::rand() % 21) / 100.0f;
     }
+    count = numParticles;
 }
 
 void ExhaustEffect::Update(float deltaTime) {
-    for (auto& p : particles) {
-        p.position.x += p.velocity.x * deltaTime;
-        p.position.y += p.velocity.y * deltaTime;
-        p.lifetime -= deltaTime;
+    int removed = 0;
+    for (int i = 0; i < count; ) {
+        positionX[i] += velocityX[i] * deltaTime;
+        positionY[i] += velocityY[i] * deltaTime;
+        lifetime[i] -= deltaTime;
+        if (lifetime[i] <= 0.0f) {
+            // The last particle moves into slot i and is updated next.
+            Remove(i);
+            removed++;
+        } else {
+            ++i;
+        }
     }
-    size_t before = particles.size();
-    particles.erase(std::remove_if(particles.begin(), particles.end(),
-        [](const Particle& p) { return p.lifetime <= 0.0f; }),
-        particles.end());
-    size_t removed = before - particles.size();
     if (removed > 0) {
-        std::cout << "DEBUG: ExhaustEffect::Update - Removed " << removed 
-                  << " expired particles. " << particles.size() 
-                  << " remain." << std::endl;
+        EXHAUST_TRACE("ExhaustEffect::Update - Removed " << removed
+                      << " expired particles. " << count << " remain.");
     }
 }
 
 void ExhaustEffect::Draw(ImDrawList* draw_list) {
-    for (const auto& p : particles) {
-        float alpha = p.lifetime / p.initialLifetime;
+    for (int i = 0; i < count; ++i) {
+        float alpha = lifetime[i] / initialLifetime[i];
         // Use the UI green color (109,254,149) with alpha modulation.
         ImU32 color = IM_COL32(109, 254, 149, static_cast<int>(alpha * 255));
         // Draw a 2x2 pixel square.
-        ImVec2 pos = p.position;
+        ImVec2 pos(positionX[i], positionY[i]);
         draw_list->AddRectFilled(pos, ImVec2(pos.x + 2.0f, pos.y + 2.0f), color);
     }
 }
+
+// -----------------------------------------------------------------------------
+// Private Helper Functions
+// -----------------------------------------------------------------------------
+void ExhaustEffect::Remove(int index) {
+    int last = --count;
+    positionX[index] = positionX[last];
+    positionY[index] = positionY[last];
+    velocityX[index] = velocityX[last];
+    velocityY[index] = velocityY[last];
+    lifetime[index] = lifetime[last];
+    initialLifetime[index] = initialLifetime[last];
+}
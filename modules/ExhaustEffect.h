@@ -2,10 +2,12 @@
 #define EXHAUST_EFFECT_H
 
 #include "imgui.h"
-#include <vector>
 
 class ExhaustEffect {
 public:
+    // Upper bound on live particles; the pool never allocates.
+    static constexpr int MAX_PARTICLES = 64;
+
     ExhaustEffect();
     // Trigger a new exhaust puff at the given position.
     void Trigger(const ImVec2& position);
@@ -13,15 +15,20 @@ public:
     void Update(float deltaTime);
     // Draw particles to the provided draw list.
     void Draw(ImDrawList* draw_list);
+    // True while any particle is still alive (the effect needs new frames).
+    bool IsActive() const { return count > 0; }
     
 private:
-    struct Particle {
-        ImVec2 position;
-        ImVec2 velocity;
-        float lifetime;       // Remaining lifetime (seconds)
-        float initialLifetime; // Initial lifetime (for fade calculations)
-    };
-    std::vector<Particle> particles;
+    // Structure of arrays; live particles are packed into [0, count).
+    float positionX[MAX_PARTICLES];
+    float positionY[MAX_PARTICLES];
+    float velocityX[MAX_PARTICLES];
+    float velocityY[MAX_PARTICLES];
+    float lifetime[MAX_PARTICLES];        // Remaining lifetime (seconds)
+    float initialLifetime[MAX_PARTICLES]; // Initial lifetime (for fade calculations)
+    int count;
+
+    void Remove(int index);
 };
 
 #endif // EXHAUST_EFFECT_H
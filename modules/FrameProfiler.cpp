@@ -0,0 +1,231 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Set from the signal handler, consumed by the render thread.
+static std::atomic<bool> dumpRequested(false);
+
+static void HandleDumpSignal(int)
+{
+    dumpRequested.store(true, std::memory_order_relaxed);
+}
+
+// Writes 'text' as a JSON string literal.
+static void WriteJSONString(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (const char* c = text; *c; ++c) {
+        unsigned char ch = static_cast<unsigned char>(*c);
+        if (ch == '"' || ch == '\\')
+            fprintf(file, "\\%c", ch);
+        else if (ch < 0x20)
+            fprintf(file, "\\u%04x", ch);
+        else
+            fputc(ch, file);
+    }
+    fputc('"', file);
+}
+
+// Nearest-rank percentile of an already sorted range.
+static float Percentile(const std::vector<float>& sorted, float p)
+{
+    if (sorted.empty())
+        return 0.0f;
+    size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5f);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+FrameProfiler::FrameProfiler()
+    : writeIndex(0),
+      underrunIndex(0)
+{
+    current.fill(0.0f);
+}
+
+void FrameProfiler::BeginFrame()
+{
+    current.fill(0.0f);
+    BeginPhase(FramePhase::Frame);
+}
+
+void FrameProfiler::BeginPhase(FramePhase phase)
+{
+    phaseStart[static_cast<size_t>(phase)] = Clock::now();
+}
+
+void FrameProfiler::EndPhase(FramePhase phase)
+{
+    size_t i = static_cast<size_t>(phase);
+    std::chrono::duration<float, std::milli> elapsed = Clock::now() - phaseStart[i];
+    current[i] += elapsed.count();
+}
+
+void FrameProfiler::EndFrame()
+{
+    EndPhase(FramePhase::Frame);
+    size_t index = writeIndex.load(std::memory_order_relaxed);
+    ring[index % CAPACITY] = current;
+    writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void FrameProfiler::RecordAudioUnderrun(double time, float lateMs, const std::string& track)
+{
+    Underrun& underrun = underruns[underrunIndex % UNDERRUN_CAPACITY];
+    underrun.time = time;
+    underrun.lateMs = lateMs;
+    size_t last = writeIndex.load(std::memory_order_relaxed);
+    underrun.frameMs = (last > 0) ? ring[(last - 1) % CAPACITY][static_cast<size_t>(FramePhase::Frame)] : 0.0f;
+    snprintf(underrun.track, sizeof(underrun.track), "%s", track.c_str());
+    underrunIndex++;
+}
+
+size_t FrameProfiler::GetSampleCount() const
+{
+    return std::min(writeIndex.load(std::memory_order_acquire), CAPACITY);
+}
+
+FrameProfiler::PhaseStats FrameProfiler::ComputeStats(FramePhase phase) const
+{
+    std::vector<float> values(GetSampleCount());
+    CollectPhase(phase, values.data(), values.size());
+    std::sort(values.begin(), values.end());
+
+    PhaseStats stats;
+    stats.p50 = Percentile(values, 0.50f);
+    stats.p95 = Percentile(values, 0.95f);
+    stats.p99 = Percentile(values, 0.99f);
+    stats.max = values.empty() ? 0.0f : values.back();
+    return stats;
+}
+
+bool FrameProfiler::DumpCSV(const std::string& path) const
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s for writing.\n", path.c_str());
+        return false;
+    }
+    size_t samples = GetSampleCount();
+    fprintf(file, "phase,samples,p50_ms,p95_ms,p99_ms,max_ms\n");
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        FramePhase phase = static_cast<FramePhase>(i);
+        PhaseStats stats = ComputeStats(phase);
+        fprintf(file, "%s,%zu,%.3f,%.3f,%.3f,%.3f\n", GetPhaseName(phase), samples,
+                stats.p50, stats.p95, stats.p99, stats.max);
+    }
+    fclose(file);
+    return true;
+}
+
+bool FrameProfiler::DumpJSON(const std::string& path) const
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s for writing.\n", path.c_str());
+        return false;
+    }
+    fprintf(file, "{\n  \"samples\": %zu,\n  \"phases\": {\n", GetSampleCount());
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        FramePhase phase = static_cast<FramePhase>(i);
+        PhaseStats stats = ComputeStats(phase);
+        fprintf(file, "    \"%s\": { \"p50_ms\": %.3f, \"p95_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f }%s\n",
+                GetPhaseName(phase), stats.p50, stats.p95, stats.p99, stats.max,
+                (i + 1 < PHASE_COUNT) ? "," : "");
+    }
+    fprintf(file, "  },\n  \"audio_underruns\": %zu,\n  \"recent_underruns\": [\n", underrunIndex);
+    size_t stored = GetStoredUnderrunCount();
+    for (size_t n = 0; n < stored; ++n) {
+        const Underrun& underrun = underruns[(underrunIndex - stored + n) % UNDERRUN_CAPACITY];
+        fprintf(file, "    { \"time_s\": %.3f, \"late_ms\": %.3f, \"frame_ms\": %.3f, \"track\": ",
+                underrun.time, underrun.lateMs, underrun.frameMs);
+        WriteJSONString(file, underrun.track);
+        fprintf(file, " }%s\n", (n + 1 < stored) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+bool FrameProfiler::DumpUnderrunsCSV(const std::string& path) const
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s for writing.\n", path.c_str());
+        return false;
+    }
+    fprintf(file, "time_s,late_ms,frame_ms,track\n");
+    size_t stored = GetStoredUnderrunCount();
+    for (size_t n = 0; n < stored; ++n) {
+        const Underrun& underrun = underruns[(underrunIndex - stored + n) % UNDERRUN_CAPACITY];
+        fprintf(file, "%.3f,%.3f,%.3f,\"", underrun.time, underrun.lateMs, underrun.frameMs);
+        for (const char* c = underrun.track; *c; ++c) {
+            if (*c == '"')
+                fputc('"', file);
+            fputc(*c, file);
+        }
+        fprintf(file, "\"\n");
+    }
+    fclose(file);
+    return true;
+}
+
+void FrameProfiler::Dump() const
+{
+    const char* dir = getenv("RADI0_PROFILE_DIR");
+    std::string base = std::string((dir && *dir) ? dir : "/tmp") + "/radi0_frame_timings";
+    if (DumpCSV(base + ".csv") && DumpJSON(base + ".json"))
+        printf("Wrote %zu frame timing sample(s) to %s.{csv,json}\n", GetSampleCount(), base.c_str());
+    std::string underrunPath = std::string((dir && *dir) ? dir : "/tmp") + "/radi0_audio_underruns.csv";
+    if (DumpUnderrunsCSV(underrunPath))
+        printf("Wrote %zu audio underrun(s) to %s\n", GetStoredUnderrunCount(), underrunPath.c_str());
+}
+
+void FrameProfiler::InstallSignalHandler()
+{
+    std::signal(SIGUSR1, HandleDumpSignal);
+}
+
+void FrameProfiler::RequestDump()
+{
+    dumpRequested.store(true, std::memory_order_relaxed);
+}
+
+bool FrameProfiler::ConsumeDumpRequest()
+{
+    return dumpRequested.exchange(false, std::memory_order_relaxed);
+}
+
+const char* FrameProfiler::GetPhaseName(FramePhase phase)
+{
+    switch (phase) {
+        case FramePhase::EventPoll:      return "event_poll";
+        case FramePhase::AudioUpdate:    return "audio_update";
+        case FramePhase::NewFrame:       return "new_frame";
+        case FramePhase::UIRender:       return "ui_render";
+        case FramePhase::Exhaust:        return "exhaust";
+        case FramePhase::ImGuiRender:    return "imgui_render";
+        case FramePhase::RenderDrawData: return "render_draw_data";
+        case FramePhase::SwapWindow:     return "swap_window";
+        case FramePhase::Frame:          return "frame";
+        default:                         return "unknown";
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Private Helper Functions
+// -----------------------------------------------------------------------------
+void FrameProfiler::CollectPhase(FramePhase phase, float* out, size_t count) const
+{
+    size_t end = writeIndex.load(std::memory_order_acquire);
+    size_t i = static_cast<size_t>(phase);
+    for (size_t n = 0; n < count; ++n)
+        out[n] = ring[(end - count + n) % CAPACITY][i];
+}
+
+size_t FrameProfiler::GetStoredUnderrunCount() const
+{
+    return std::min(underrunIndex, UNDERRUN_CAPACITY);
+}
@@ -0,0 +1,115 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// Phases of the main loop that get their own timing column.
+enum class FramePhase {
+    EventPoll,
+    AudioUpdate,
+    NewFrame,
+    UIRender,
+    Exhaust,
+    ImGuiRender,
+    RenderDrawData,
+    SwapWindow,
+    Frame,          // Whole frame, from BeginFrame() to EndFrame().
+    Count
+};
+
+// Records per-phase frame timings into a fixed-size ring buffer.
+// There is a single writer (the render thread); committed samples are
+// published with release semantics so a reader never sees a torn index.
+// Nothing is allocated while recording; only dumping allocates.
+class FrameProfiler {
+public:
+    static constexpr size_t CAPACITY = 4096;   // Frames kept (~68 s at 60 Hz).
+    static constexpr size_t PHASE_COUNT = static_cast<size_t>(FramePhase::Count);
+
+    struct PhaseStats {
+        float p50;
+        float p95;
+        float p99;
+        float max;
+    };
+
+    FrameProfiler();
+
+    // Starts a new sample. A sample that was begun but never committed
+    // (an idle wake-up that did not render) is simply overwritten.
+    void BeginFrame();
+    void BeginPhase(FramePhase phase);
+    void EndPhase(FramePhase phase);
+    // Commits the current sample to the ring buffer.
+    void EndFrame();
+
+    // Notes an audio underrun: 'time' in seconds on SDL's performance
+    // counter (its epoch is arbitrary, so only differences between times
+    // mean anything), how late the mixer callback was, and what was
+    // playing. The last committed frame time is stored alongside, to tell
+    // UI stalls from I/O stalls.
+    void RecordAudioUnderrun(double time, float lateMs, const std::string& track);
+    size_t GetUnderrunCount() const { return underrunIndex; }
+
+    size_t GetSampleCount() const;
+    // Milliseconds, over the samples currently in the ring.
+    PhaseStats ComputeStats(FramePhase phase) const;
+
+    bool DumpCSV(const std::string& path) const;
+    bool DumpJSON(const std::string& path) const;
+    bool DumpUnderrunsCSV(const std::string& path) const;
+    // Writes <dir>/radi0_frame_timings.{csv,json} and
+    // <dir>/radi0_audio_underruns.csv; dir comes from $RADI0_PROFILE_DIR
+    // and defaults to /tmp.
+    void Dump() const;
+
+    // Dump requests can come from a key press or from SIGUSR1.
+    void InstallSignalHandler();
+    void RequestDump();
+    bool ConsumeDumpRequest();
+
+    static const char* GetPhaseName(FramePhase phase);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::array<float, PHASE_COUNT> Sample;
+
+    struct Underrun {
+        double time;
+        float lateMs;
+        float frameMs;
+        char track[96];   // Truncated, so recording does not allocate
+    };
+    static constexpr size_t UNDERRUN_CAPACITY = 256;
+
+    void CollectPhase(FramePhase phase, float* out, size_t count) const;
+    size_t GetStoredUnderrunCount() const;
+
+    std::array<Sample, CAPACITY> ring;
+    std::atomic<size_t> writeIndex;   // Total samples ever committed.
+
+    // Written and read on the render thread only.
+    std::array<Underrun, UNDERRUN_CAPACITY> underruns;
+    size_t underrunIndex;             // Total underruns ever recorded.
+
+    Sample current;
+    std::array<Clock::time_point, PHASE_COUNT> phaseStart;
+};
+
+// Times a phase for the lifetime of the object.
+class ScopedPhase {
+public:
+    ScopedPhase(FrameProfiler& profiler, FramePhase phase)
+        : profiler(profiler), phase(phase) { profiler.BeginPhase(phase); }
+    ~ScopedPhase() { profiler.EndPhase(phase); }
+
+private:
+    FrameProfiler& profiler;
+    FramePhase phase;
+};
+
+#endif // FRAME_PROFILER_H
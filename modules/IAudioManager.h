@@ -2,6 +2,7 @@
 #define IAUDIOMANAGER_H
 
 #include <string>
+#include <atomic>
 
 enum class PlaybackState {
     Stopped,
@@ -9,6 +10,37 @@ enum class PlaybackState {
     Paused
 };
 
+// Everything the UI draws from an audio manager, refreshed once per wake-up.
+// 'version' changes whenever the track metadata (title, artist, duration)
+// does; the strings are only copied when it differs from the manager's, so
+// refreshing a snapshot of an unchanged track never allocates.
+struct PlaybackSnapshot {
+    unsigned long long version = 0;   // 0 = never filled.
+    PlaybackState state = PlaybackState::Stopped;
+    int volume = 0;
+    float fraction = 0.0f;
+    float position = 0.0f;
+    float duration = 0.0f;
+    std::string title;
+    std::string artist;
+};
+
+// A mixer callback that came too late to keep the audio device fed; heard
+// as a crackle.
+struct AudioUnderrun {
+    double time = 0.0;      // Seconds on SDL's performance counter (arbitrary epoch)
+    float lateMs = 0.0f;    // Gap between callbacks beyond one period
+    std::string track;      // What was playing
+};
+
+// Hands out metadata versions. The counter is shared by all managers, so a
+// snapshot never mistakes a new manager's metadata for the old one's.
+inline unsigned long long NextPlaybackVersion()
+{
+    static std::atomic<unsigned long long> counter(0);
+    return ++counter;
+}
+
 class IAudioManager {
 public:
     virtual ~IAudioManager() {}
@@ -37,6 +69,29 @@ public:
     virtual std::string GetCurrentTrackArtist() const = 0;
     virtual float GetCurrentTrackDuration() const = 0;
     virtual float GetCurrentPlaybackPosition() const = 0;
+
+    // Version of the current metadata, taken from NextPlaybackVersion()
+    // whenever the title, artist or duration changes.
+    virtual unsigned long long GetMetadataVersion() const = 0;
+
+    // Hands out underruns detected since the last call, one per call.
+    // Managers that do not drive the mixer have none.
+    virtual bool PollUnderrun(AudioUnderrun& /*underrun*/) { return false; }
+
+    // Refreshes 'snapshot'; see PlaybackSnapshot.
+    void GetSnapshot(PlaybackSnapshot& snapshot) const {
+        snapshot.state = GetState();
+        snapshot.volume = GetVolume();
+        snapshot.fraction = GetPlaybackFraction();
+        snapshot.position = GetCurrentPlaybackPosition();
+        unsigned long long version = GetMetadataVersion();
+        if (snapshot.version != version) {
+            snapshot.title = GetCurrentTrackTitle();
+            snapshot.artist = GetCurrentTrackArtist();
+            snapshot.duration = GetCurrentTrackDuration();
+            snapshot.version = version;
+        }
+    }
 };
 
 #endif // IAUDIOMANAGER_H
@@ -0,0 +1,310 @@
+#include "Id3Reader.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const size_t ID3V2_HEADER_SIZE = 10;
+static const size_t ID3V1_SIZE = 128;
+// Read along with the tag header; enough for the text frames of most tags,
+// which come before the cover art.
+static const size_t ID3V2_WINDOW_SIZE = 4096;
+
+static uint32_t readSyncsafe32(const unsigned char* p)
+{
+    return (uint32_t(p[0] & 0x7F) << 21) | (uint32_t(p[1] & 0x7F) << 14) |
+           (uint32_t(p[2] & 0x7F) << 7) | uint32_t(p[3] & 0x7F);
+}
+
+static uint32_t readBigEndian32(const unsigned char* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+// Undoes unsynchronisation: every 0xFF 0x00 pair was written for a 0xFF.
+static void removeUnsynchronisation(const unsigned char* data, size_t size, std::string& out)
+{
+    out.clear();
+    out.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        out.push_back(static_cast<char>(data[i]));
+        if (data[i] == 0xFF && i + 1 < size && data[i + 1] == 0x00)
+            i++;
+    }
+}
+
+static void appendUtf8(std::string& out, uint32_t codepoint)
+{
+    if (codepoint < 0x80) {
+        out.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+static void decodeUtf16(const unsigned char* data, size_t size, bool bigEndian, std::string& out)
+{
+    out.clear();
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        uint32_t unit = bigEndian ? (data[i] << 8 | data[i + 1]) : (data[i + 1] << 8 | data[i]);
+        if (unit == 0)
+            break;
+        if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < size) {
+            uint32_t low = bigEndian ? (data[i + 2] << 8 | data[i + 3]) : (data[i + 3] << 8 | data[i + 2]);
+            if (low >= 0xDC00 && low < 0xE000) {
+                appendUtf8(out, 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+                i += 2;
+                continue;
+            }
+        }
+        appendUtf8(out, unit);
+    }
+}
+
+// Trailing spaces and NULs pad ID3v1 fields and some v2 frames.
+static std::string_view trimText(std::string_view text)
+{
+    size_t end = text.find('\0');
+    if (end == std::string_view::npos)
+        end = text.size();
+    while (end > 0 && text[end - 1] == ' ')
+        end--;
+    return text.substr(0, end);
+}
+
+Id3Reader::Id3Reader()
+    : fd(-1),
+      window(nullptr),
+      windowSize(0)
+{
+}
+
+Id3Reader::~Id3Reader()
+{
+    Close();
+}
+
+bool Id3Reader::Open(const std::string& path)
+{
+    Close();
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    // Frames are visited by hopping over their sizes; don't let readahead
+    // pull in the cover art we skip.
+    posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+
+    // The tag header and the start of the tag in one read.
+    headBuffer.resize(ID3V2_HEADER_SIZE + ID3V2_WINDOW_SIZE);
+    ssize_t got = pread(fd, headBuffer.data(), headBuffer.size(), 0);
+    const unsigned char* header = headBuffer.data();
+    if (got >= static_cast<ssize_t>(ID3V2_HEADER_SIZE) &&
+        std::memcmp(header, "ID3", 3) == 0 && (header[3] == 3 || header[3] == 4)) {
+        size_t tagSize = readSyncsafe32(header + 6);
+        size_t headSize = std::max(std::min(ID3V2_HEADER_SIZE + tagSize, fileSize), ID3V2_HEADER_SIZE);
+        window = header + ID3V2_HEADER_SIZE;
+        windowSize = std::min(static_cast<size_t>(got), headSize) - ID3V2_HEADER_SIZE;
+        readId3v2(headSize - ID3V2_HEADER_SIZE, header[3], header[5]);
+    }
+
+    if ((title.empty() || artist.empty()) && fileSize >= ID3V1_SIZE) {
+        tailBuffer.resize(ID3V1_SIZE);
+        if (pread(fd, tailBuffer.data(), ID3V1_SIZE, static_cast<off_t>(fileSize - ID3V1_SIZE)) ==
+                static_cast<ssize_t>(ID3V1_SIZE) &&
+            std::memcmp(tailBuffer.data(), "TAG", 3) == 0)
+            readId3v1(tailBuffer.data());
+    }
+    close(fd);
+    fd = -1;
+    return !title.empty() || !artist.empty();
+}
+
+// The buffers are kept for the next file; only the views are dropped.
+void Id3Reader::Close()
+{
+    window = nullptr;
+    windowSize = 0;
+    title = std::string_view();
+    artist = std::string_view();
+}
+
+// 'length' bytes of the tag from 'pos' (counted after the tag header): in
+// the window if they lie within it, else read into 'buffer'. nullptr if the
+// read fails, as it does once the stick is pulled.
+const unsigned char* Id3Reader::fetch(size_t pos, size_t length, std::vector<unsigned char>& buffer)
+{
+    if (length <= windowSize && pos <= windowSize - length)
+        return window + pos;
+    buffer.resize(std::max<size_t>(length, 1));
+    ssize_t got = pread(fd, buffer.data(), length, static_cast<off_t>(ID3V2_HEADER_SIZE + pos));
+    return (got == static_cast<ssize_t>(length)) ? buffer.data() : nullptr;
+}
+
+// 'size' is the tag's size after its header; the first windowSize bytes of
+// it are already in the window.
+void Id3Reader::readId3v2(size_t size, int version, unsigned char flags)
+{
+    // In v2.3 the unsynchronisation flag covers the whole tag, extended
+    // header included, so the whole tag is read and it is undone once up
+    // front; frameStorage is not written again and views into it stay
+    // valid. v2.4 does it per frame.
+    bool unsynchronised = (flags & 0x80) != 0;
+    if (unsynchronised && version == 3) {
+        if (size > windowSize) {
+            headBuffer.resize(ID3V2_HEADER_SIZE + size);
+            ssize_t got = pread(fd, headBuffer.data() + ID3V2_HEADER_SIZE, size, ID3V2_HEADER_SIZE);
+            if (got != static_cast<ssize_t>(size))
+                return;
+        }
+        removeUnsynchronisation(headBuffer.data() + ID3V2_HEADER_SIZE, size, frameStorage);
+        window = reinterpret_cast<const unsigned char*>(frameStorage.data());
+        windowSize = size = frameStorage.size();
+    }
+
+    size_t pos = 0;
+    if ((flags & 0x40) && size >= 4) {
+        const unsigned char* extendedSize = fetch(0, 4, headerBuffer);
+        if (!extendedSize)
+            return;
+        // Extended header: the v2.3 size excludes itself, v2.4 (syncsafe) includes it.
+        // Checked before adding, so a corrupt size cannot wrap a 32-bit size_t.
+        size_t extended = (version == 3) ? readBigEndian32(extendedSize) : readSyncsafe32(extendedSize);
+        size_t limit = (version == 3) ? size - 4 : size;
+        if (extended > limit)
+            return;
+        pos = (version == 3) ? extended + 4 : extended;
+    }
+
+    bool leadArtist = false;
+    while (pos + ID3V2_HEADER_SIZE <= size && (title.empty() || !leadArtist)) {
+        const unsigned char* frame = fetch(pos, ID3V2_HEADER_SIZE, headerBuffer);
+        if (!frame || frame[0] == 0)
+            break;   // Unreadable, or padding
+        size_t frameSize = (version == 4) ? readSyncsafe32(frame + 4) : readBigEndian32(frame + 4);
+        unsigned char format = frame[9];
+        size_t dataPos = pos + ID3V2_HEADER_SIZE;
+        // Compared before adding: on a 32-bit size_t a corrupt size could
+        // wrap pos backwards and keep the scan going forever.
+        if (frameSize > size - pos - ID3V2_HEADER_SIZE)
+            break;
+        pos += ID3V2_HEADER_SIZE + frameSize;
+
+        // TPE2 (album artist) only stands in for a missing TPE1.
+        bool isTitle = std::memcmp(frame, "TIT2", 4) == 0;
+        bool isArtist = std::memcmp(frame, "TPE1", 4) == 0;
+        bool isBand = std::memcmp(frame, "TPE2", 4) == 0;
+        if (!isTitle && !isArtist && !(isBand && artist.empty()))
+            continue;
+
+        // Compressed or encrypted frames are skipped.
+        bool encoded = (version == 4) ? (format & 0x0C) != 0 : (format & 0xC0) != 0;
+        if (encoded)
+            continue;
+        // Only now is the frame body read, if it is past the window.
+        const unsigned char* data = fetch(dataPos, frameSize, isTitle ? titleBuffer : artistBuffer);
+        if (!data) {
+            // The view may have pointed into the buffer just overwritten.
+            (isTitle ? title : artist) = std::string_view();
+            break;
+        }
+        if (version == 4 && (format & 0x01)) {
+            // Data length indicator.
+            if (frameSize < 4)
+                continue;
+            data += 4;
+            frameSize -= 4;
+        }
+        bool copied = false;
+        if (version == 4 && (unsynchronised || (format & 0x02))) {
+            removeUnsynchronisation(data, frameSize, frameStorage);
+            data = reinterpret_cast<const unsigned char*>(frameStorage.data());
+            frameSize = frameStorage.size();
+            copied = true;
+        }
+
+        std::string& storage = isTitle ? titleStorage : artistStorage;
+        std::string_view text = decodeText(data, frameSize, storage);
+        // The next frame reuses frameStorage.
+        if (copied && text.data() != storage.data())
+            text = storage.assign(text.data(), text.size());
+        if (isTitle) {
+            title = text;
+        } else {
+            artist = text;
+            leadArtist = isArtist;
+        }
+    }
+}
+
+void Id3Reader::readId3v1(const unsigned char* tag)
+{
+    // Fixed 30-byte Latin-1 fields: title at 3, artist at 33.
+    if (title.empty())
+        title = decodeLatin1(reinterpret_cast<const char*>(tag + 3), 30, titleStorage);
+    if (artist.empty())
+        artist = decodeLatin1(reinterpret_cast<const char*>(tag + 33), 30, artistStorage);
+}
+
+// ASCII is returned as is; other Latin-1 text is converted in 'storage'.
+std::string_view Id3Reader::decodeLatin1(const char* text, size_t length, std::string& storage)
+{
+    std::string_view view = trimText(std::string_view(text, length));
+    bool ascii = true;
+    for (char c : view)
+        ascii = ascii && static_cast<unsigned char>(c) < 0x80;
+    if (ascii)
+        return view;
+    storage.clear();
+    for (char c : view)
+        appendUtf8(storage, static_cast<unsigned char>(c));
+    return storage;
+}
+
+// Decodes a text frame body (encoding byte, then text) and returns its first
+// value. ASCII and UTF-8 text is returned as a view into 'data'; anything
+// else is converted to UTF-8 in 'storage'.
+std::string_view Id3Reader::decodeText(const unsigned char* data, size_t size, std::string& storage)
+{
+    if (size < 2)
+        return std::string_view();
+    unsigned char encoding = data[0];
+    const unsigned char* text = data + 1;
+    size_t length = size - 1;
+
+    switch (encoding) {
+    case 1:   // UTF-16 with BOM
+        if (length >= 2 && text[0] == 0xFE && text[1] == 0xFF)
+            decodeUtf16(text + 2, length - 2, true, storage);
+        else if (length >= 2 && text[0] == 0xFF && text[1] == 0xFE)
+            decodeUtf16(text + 2, length - 2, false, storage);
+        else
+            decodeUtf16(text, length, false, storage);
+        return trimText(storage);
+    case 2:   // UTF-16BE
+        decodeUtf16(text, length, true, storage);
+        return trimText(storage);
+    case 3:   // UTF-8
+        return trimText(std::string_view(reinterpret_cast<const char*>(text), length));
+    default:
+        return decodeLatin1(reinterpret_cast<const char*>(text), length, storage);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef ID3_READER_H
+#define ID3_READER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Reads the title and artist from a file's ID3v2.3/2.4 tag, falling back to
+// an ID3v1 tag at the end.
+//
+// The first few KB of the tag and the last 128 bytes are read with pread();
+// frames past that window are read one by one, and frames other than the
+// ones we want (cover art, mostly) are skipped without being read from the
+// drive. pread() rather than mmap() because the files are on a removable
+// stick: pulled mid-scan, a read fails with EIO where a page fault in a
+// mapping would raise SIGBUS and kill the process. The returned views point
+// into the reader's buffers, which are reused from file to file. Views stay
+// valid until the next Open() or Close(), so callers copy only the strings
+// they keep.
+//
+// One reader is meant to be reused for many files on the same thread.
+class Id3Reader {
+public:
+    Id3Reader();
+    ~Id3Reader();
+
+    // Returns true if the file has a tag with a title or an artist.
+    bool Open(const std::string& path);
+    void Close();
+
+    std::string_view GetTitle() const { return title; }
+    std::string_view GetArtist() const { return artist; }
+
+private:
+    void readId3v2(size_t size, int version, unsigned char flags);
+    void readId3v1(const unsigned char* tag);
+    const unsigned char* fetch(size_t pos, size_t length, std::vector<unsigned char>& buffer);
+    std::string_view decodeText(const unsigned char* data, size_t size, std::string& storage);
+    std::string_view decodeLatin1(const char* text, size_t length, std::string& storage);
+
+    int fd;                        // During Open() only
+    const unsigned char* window;   // Start of the tag, after its header
+    size_t windowSize;
+    std::vector<unsigned char> headBuffer;     // Tag header and window
+    std::vector<unsigned char> headerBuffer;   // Frame header past the window
+    std::vector<unsigned char> titleBuffer;    // Title frame past the window
+    std::vector<unsigned char> artistBuffer;   // Artist frame past the window
+    std::vector<unsigned char> tailBuffer;     // ID3v1 tag
+
+    std::string_view title;
+    std::string_view artist;
+    std::string titleStorage;
+    std::string artistStorage;
+    std::string frameStorage;   // Unsynchronised frame or tag data
+};
+
+#endif // ID3_READER_H
@@ -0,0 +1,136 @@
+#include "LayerCache.h"
+#include "imgui_impl_opengl3.h"
+#include <algorithm>
+#include <cmath>
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+// The layer textures hold premultiplied color (ImGui's blend state writes
+// rgb*a into the cleared target), so they are composited with ONE instead of
+// SRC_ALPHA to keep anti-aliased edges identical to drawing them directly.
+static void UsePremultipliedBlend(const ImDrawList*, const ImDrawCmd*)
+{
+    glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+LayerCache::LayerCache()
+    : scratch(nullptr),
+      windowWidth(0),
+      windowHeight(0)
+{
+    for (Layer& layer : layers) {
+        layer.valid = false;
+        layer.empty = true;
+    }
+}
+
+LayerCache::~LayerCache()
+{
+    Cleanup();
+}
+
+ImDrawList* LayerCache::BeginLayer(int window_width, int window_height)
+{
+    // Created lazily: the draw list needs the ImGui context's shared data.
+    if (!scratch)
+        scratch = IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData());
+    windowWidth = window_width;
+    windowHeight = window_height;
+
+    scratch->_ResetForNewFrame();
+    scratch->PushTextureID(ImGui::GetIO().Fonts->TexID);
+    scratch->PushClipRect(ImVec2(0.0f, 0.0f),
+                          ImVec2(static_cast<float>(window_width), static_cast<float>(window_height)));
+    return scratch;
+}
+
+bool LayerCache::EndLayer(StaticLayer id)
+{
+    Layer& layer = layers[static_cast<int>(id)];
+    layer.valid = false;
+    layer.empty = scratch->VtxBuffer.empty();
+    if (layer.empty) {
+        layer.target.Destroy();
+        layer.valid = true;
+        return true;
+    }
+
+    // Crop the texture to the pixels the layer actually touches.
+    ImVec2 bmin(static_cast<float>(windowWidth), static_cast<float>(windowHeight));
+    ImVec2 bmax(0.0f, 0.0f);
+    for (const ImDrawVert& v : scratch->VtxBuffer) {
+        bmin.x = std::min(bmin.x, v.pos.x);
+        bmin.y = std::min(bmin.y, v.pos.y);
+        bmax.x = std::max(bmax.x, v.pos.x);
+        bmax.y = std::max(bmax.y, v.pos.y);
+    }
+    layer.min = ImVec2(std::max(0.0f, std::floor(bmin.x)), std::max(0.0f, std::floor(bmin.y)));
+    layer.max = ImVec2(std::min(static_cast<float>(windowWidth), std::ceil(bmax.x)),
+                       std::min(static_cast<float>(windowHeight), std::ceil(bmax.y)));
+    int width = static_cast<int>(layer.max.x - layer.min.x);
+    int height = static_cast<int>(layer.max.y - layer.min.y);
+    if (width <= 0 || height <= 0) {
+        layer.empty = true;
+        layer.valid = true;
+        return true;
+    }
+
+    // Texels map 1:1 to window pixels, so nearest filtering is exact.
+    if (layer.target.GetWidth() != width || layer.target.GetHeight() != height) {
+        if (!layer.target.Create(width, height, false))
+            return false;
+    }
+
+    ImDrawData draw_data;
+    draw_data.Valid = true;
+    draw_data.DisplayPos = layer.min;
+    draw_data.DisplaySize = ImVec2(static_cast<float>(width), static_cast<float>(height));
+    draw_data.FramebufferScale = ImVec2(1.0f, 1.0f);
+    draw_data.AddDrawList(scratch);
+
+    GLfloat lastClearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, lastClearColor);
+    layer.target.Bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplOpenGL3_RenderDrawData(&draw_data);
+    layer.target.Unbind();
+    glClearColor(lastClearColor[0], lastClearColor[1], lastClearColor[2], lastClearColor[3]);
+
+    layer.valid = true;
+    return true;
+}
+
+bool LayerCache::Draw(ImDrawList* draw_list, StaticLayer id) const
+{
+    const Layer& layer = layers[static_cast<int>(id)];
+    if (!layer.valid)
+        return false;
+    if (layer.empty)
+        return true;
+
+    // GL textures are bottom-up, hence the flipped V coordinates.
+    draw_list->AddCallback(UsePremultipliedBlend, nullptr);
+    draw_list->AddImage(layer.target.GetTextureID(), layer.min, layer.max,
+                        ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f));
+    draw_list->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    return true;
+}
+
+void LayerCache::Cleanup()
+{
+    for (Layer& layer : layers) {
+        layer.target.Destroy();
+        layer.valid = false;
+        layer.empty = true;
+    }
+    if (scratch) {
+        IM_DELETE(scratch);
+        scratch = nullptr;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include "imgui.h"
+#include "RenderTarget.h"
+
+// Static HUD layers, listed in the order they are composited.
+enum class StaticLayer {
+    Horizon,    // Sun mask and progress line (covers the sun).
+    Frame,      // Mask bars and borders drawn over the exhaust particles.
+    Count
+};
+
+// Caches static ImDrawList geometry in offscreen textures so it is
+// rasterized once per window-size or layout change and afterwards drawn as
+// a single textured quad per layer. Each texture is cropped to the bounds of
+// its layer's geometry to keep the per-frame fill cost down.
+class LayerCache {
+public:
+    LayerCache();
+    ~LayerCache();
+
+    // Returns a scratch draw list to record the layer's geometry into.
+    // Coordinates are window pixels, same as the window draw lists.
+    ImDrawList* BeginLayer(int window_width, int window_height);
+    // Rasterizes what was recorded since BeginLayer() into the layer's texture.
+    // Returns false if the texture could not be created.
+    bool EndLayer(StaticLayer layer);
+
+    // Emits the cached layer into draw_list. Returns false if the layer is
+    // not cached, in which case the caller has to draw it directly.
+    bool Draw(ImDrawList* draw_list, StaticLayer layer) const;
+
+    // Frees GL resources; must be called while the GL context is current.
+    void Cleanup();
+
+private:
+    struct Layer {
+        RenderTarget target;
+        ImVec2 min;
+        ImVec2 max;
+        bool valid;
+        bool empty;
+    };
+
+    Layer layers[static_cast<int>(StaticLayer::Count)];
+    ImDrawList* scratch;
+    int windowWidth;
+    int windowHeight;
+};
+
+#endif // LAYER_CACHE_H
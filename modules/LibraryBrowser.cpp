@@ -0,0 +1,377 @@
+#include "LibraryBrowser.h"
+#include "Utilities.h"
+#include <algorithm>
+#include <cstring>
+
+static const ImU32 COLOR_GREEN = IM_COL32(109, 254, 149, 255);
+static const ImU32 COLOR_BLACK = IM_COL32(0, 0, 0, 255);
+
+// Tracks appended by a running scan are indexed at most this often.
+static const std::chrono::milliseconds REBUILD_INTERVAL(1000);
+
+// Time spent copying tracks out of the store per SetLibrary() call, checked
+// every COPY_BATCH tracks.
+static const std::chrono::microseconds COPY_BUDGET(2000);
+static const size_t COPY_BATCH = 128;
+
+// ASCII letters and digits, and any byte of a UTF-8 sequence, make words.
+static bool isWordByte(unsigned char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+static char foldByte(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+LibraryBrowser::LibraryBrowser()
+    : open(false),
+      library(nullptr),
+      libraryVersion(0),
+      indexedCount(0),
+      stale(false),
+      buildVersion(0),
+      buildCount(0),
+      buildNext(0),
+      copying(false),
+      sortDone(false),
+      stamp(0),
+      selected(0),
+      scrollToSelection(false),
+      pageRows(1)
+{
+}
+
+LibraryBrowser::~LibraryBrowser()
+{
+    if (sorter.joinable())
+        sorter.join();
+}
+
+void LibraryBrowser::Open()
+{
+    if (!library)
+        return;
+    open = true;
+    scrollToSelection = true;
+}
+
+void LibraryBrowser::Close()
+{
+    open = false;
+}
+
+bool LibraryBrowser::SetLibrary(const TrackStore* store, unsigned long long version)
+{
+    // Closed, the browser only notes what changed; the work waits for Open().
+    if (store != library || version != libraryVersion) {
+        library = store;
+        libraryVersion = version;
+        // Whatever is being copied came from the old library.
+        copying = false;
+        stale = true;
+        if (!library) {
+            open = false;
+            index = Index();
+            indexedCount = 0;
+            stale = false;
+            query.clear();
+            ranges.clear();
+            results.clear();
+            selected = 0;
+        }
+    }
+
+    bool adopted = false;
+    if (sortDone.load(std::memory_order_acquire)) {
+        // Joined even while closed, so the thread does not linger.
+        sorter.join();
+        sortDone.store(false, std::memory_order_relaxed);
+        if (library && buildVersion == libraryVersion) {
+            adoptIndex();
+            adopted = true;
+        }
+    }
+    if (!library || !open)
+        return adopted && open;
+
+    auto now = std::chrono::steady_clock::now();
+    bool grown = library->GetCount() != indexedCount && now - lastBuild >= REBUILD_INTERVAL;
+    if (!copying && !sorter.joinable() && (stale || grown))
+        startBuild(library->GetCount());
+    if (copying)
+        copySlice();
+    return adopted;
+}
+
+void LibraryBrowser::Type(const char* text)
+{
+    if (!open)
+        return;
+    // While the index is rebuilt the text is only kept; adoptIndex() runs
+    // the whole query against the new index.
+    if (stale) {
+        query.append(text);
+        return;
+    }
+    extendQuery(text);
+    refilter();
+}
+
+void LibraryBrowser::Erase()
+{
+    if (!open || query.empty())
+        return;
+    // Drop a whole UTF-8 character. Stale ranges are rebuilt on adoption.
+    do {
+        query.pop_back();
+        if (!stale)
+            ranges.pop_back();
+    } while (!query.empty() && (static_cast<unsigned char>(query.back()) & 0xC0) == 0x80);
+    if (!stale)
+        refilter();
+}
+
+void LibraryBrowser::MoveSelection(int rows)
+{
+    if (results.empty())
+        return;
+    long target = static_cast<long>(selected) + rows;
+    selected = static_cast<size_t>(std::clamp(target, 0L, static_cast<long>(results.size()) - 1));
+    scrollToSelection = true;
+}
+
+bool LibraryBrowser::GetSelectedTrack(uint32_t& track) const
+{
+    if (!open || stale || selected >= results.size())
+        return false;
+    track = results[selected];
+    return true;
+}
+
+void LibraryBrowser::Draw(const ImVec2& pos, const ImVec2& size)
+{
+    if (!open || !library)
+        return;
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration |
+                             ImGuiWindowFlags_NoMove |
+                             ImGuiWindowFlags_NoSavedSettings |
+                             ImGuiWindowFlags_NoScrollWithMouse;
+    ImGui::SetNextWindowPos(pos);
+    ImGui::SetNextWindowSize(size);
+    ImGui::Begin("Library", nullptr, flags);
+    ImGui::SetWindowFontScale(TEXT_FONT_SCALE);
+
+    ImGui::Text("> %s_", query.c_str());
+    ImGui::SameLine();
+    if (stale)
+        ImGui::TextDisabled("  Reading library... %d%%", buildCount ? static_cast<int>(buildNext * 100 / buildCount) : 0);
+    else
+        ImGui::TextDisabled("  %zu of %zu", results.size(), index.sorted.size());
+    ImGui::Separator();
+    if (stale) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::BeginChild("Rows", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_NoScrollbar);
+    ImGui::SetWindowFontScale(TEXT_FONT_SCALE);
+    float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    float visible = ImGui::GetWindowHeight();
+    pageRows = std::max(1, static_cast<int>(visible / rowHeight));
+    if (scrollToSelection) {
+        float top = selected * rowHeight;
+        if (top < ImGui::GetScrollY())
+            ImGui::SetScrollY(top);
+        else if (top + rowHeight > ImGui::GetScrollY() + visible)
+            ImGui::SetScrollY(top + rowHeight - visible);
+        scrollToSelection = false;
+    }
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    float width = ImGui::GetContentRegionAvail().x;
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(results.size()), rowHeight);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            uint32_t track = results[row];
+            std::string_view artist = library->GetArtist(track);
+            std::string_view title = library->GetTitle(track);
+            bool isSelected = static_cast<size_t>(row) == selected;
+            if (isSelected) {
+                ImVec2 start = ImGui::GetCursorScreenPos();
+                drawList->AddRectFilled(start, ImVec2(start.x + width, start.y + rowHeight), COLOR_GREEN);
+                ImGui::PushStyleColor(ImGuiCol_Text, COLOR_BLACK);
+            }
+            ImGui::TextUnformatted(artist.data(), artist.data() + artist.size());
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::TextUnformatted(" - ");
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::TextUnformatted(title.data(), title.data() + title.size());
+            if (isSelected)
+                ImGui::PopStyleColor();
+        }
+    }
+    ImGui::EndChild();
+    ImGui::End();
+}
+
+// -----------------------------------------------------------------------------
+// Private Helper Functions
+// -----------------------------------------------------------------------------
+
+void LibraryBrowser::startBuild(size_t count)
+{
+    building = Index();
+    building.artistAt.reserve(count);
+    building.titleAt.reserve(count);
+    buildVersion = libraryVersion;
+    buildCount = count;
+    buildNext = 0;
+    copying = true;
+    lastBuild = std::chrono::steady_clock::now();
+}
+
+// Appends the next tracks' artist and title, lowercased and NUL-terminated,
+// and a Word for each word start in them. Hands the index to the sorter
+// once every track is in.
+void LibraryBrowser::copySlice()
+{
+    auto deadline = std::chrono::steady_clock::now() + COPY_BUDGET;
+    for (; buildNext < buildCount; buildNext++) {
+        if (buildNext % COPY_BATCH == 0 && std::chrono::steady_clock::now() >= deadline)
+            break;
+        uint32_t track = static_cast<uint32_t>(buildNext);
+        for (int field = 0; field < 2; field++) {
+            std::string_view text = (field == 0) ? library->GetArtist(track) : library->GetTitle(track);
+            std::vector<uint32_t>& at = (field == 0) ? building.artistAt : building.titleAt;
+            at.push_back(static_cast<uint32_t>(building.folded.size()));
+            bool inWord = false;
+            for (char c : text) {
+                bool wordByte = isWordByte(static_cast<unsigned char>(c));
+                if (wordByte && !inWord)
+                    building.words.push_back(Word{ static_cast<uint32_t>(building.folded.size()), track });
+                inWord = wordByte;
+                building.folded.push_back(foldByte(c));
+            }
+            building.folded.push_back('\0');
+        }
+    }
+    if (buildNext < buildCount)
+        return;
+    copying = false;
+    sorter = std::thread([this] {
+        sortIndex(building);
+        sortDone.store(true, std::memory_order_release);
+    });
+}
+
+// Runs on the sorter thread; only touches 'built'.
+void LibraryBrowser::sortIndex(Index& built)
+{
+    const char* base = built.folded.c_str();
+    size_t count = built.artistAt.size();
+    built.sorted.resize(count);
+    for (size_t i = 0; i < count; i++)
+        built.sorted[i] = static_cast<uint32_t>(i);
+    std::sort(built.sorted.begin(), built.sorted.end(), [&built, base](uint32_t a, uint32_t b) {
+        int order = std::strcmp(base + built.artistAt[a], base + built.artistAt[b]);
+        if (order == 0)
+            order = std::strcmp(base + built.titleAt[a], base + built.titleAt[b]);
+        return order < 0;
+    });
+    built.rank.resize(count);
+    for (size_t i = 0; i < count; i++)
+        built.rank[built.sorted[i]] = static_cast<uint32_t>(i);
+    std::sort(built.words.begin(), built.words.end(), [base](const Word& a, const Word& b) {
+        return std::strcmp(base + a.offset, base + b.offset) < 0;
+    });
+    built.artistAt = std::vector<uint32_t>();
+    built.titleAt = std::vector<uint32_t>();
+}
+
+// Swaps in the sorted index and runs the query against it again.
+void LibraryBrowser::adoptIndex()
+{
+    bool wasStale = stale;
+    index.folded.swap(building.folded);
+    index.words.swap(building.words);
+    index.sorted.swap(building.sorted);
+    index.rank.swap(building.rank);
+    building = Index();
+    indexedCount = buildCount;
+    stale = false;
+    seen.assign(indexedCount, 0);
+    stamp = 0;
+    if (wasStale) {
+        // The old results named other tracks.
+        results.clear();
+        selected = 0;
+    }
+    std::string typed;
+    typed.swap(query);
+    ranges.clear();
+    extendQuery(typed.c_str());
+    refilter();
+}
+
+void LibraryBrowser::extendQuery(const char* text)
+{
+    const char* base = index.folded.c_str();
+    for (const char* c = text; *c; ++c) {
+        query.push_back(foldByte(*c));
+        // Only words already matching the shorter query can match this one.
+        size_t low = ranges.empty() ? 0 : ranges.back().first;
+        size_t high = ranges.empty() ? index.words.size() : ranges.back().second;
+        const char* prefix = query.c_str();
+        size_t length = query.size();
+        auto begin = index.words.begin();
+        auto first = std::partition_point(begin + low, begin + high, [&](const Word& word) {
+            return std::strncmp(base + word.offset, prefix, length) < 0;
+        });
+        auto last = std::partition_point(first, begin + high, [&](const Word& word) {
+            return std::strncmp(base + word.offset, prefix, length) == 0;
+        });
+        ranges.emplace_back(first - begin, last - begin);
+    }
+}
+
+void LibraryBrowser::refilter()
+{
+    uint32_t keep = 0;
+    bool hadSelection = selected < results.size() && results[selected] < index.rank.size();
+    if (hadSelection)
+        keep = results[selected];
+
+    if (query.empty()) {
+        results = index.sorted;
+    } else {
+        results.clear();
+        if (++stamp == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            stamp = 1;
+        }
+        for (size_t i = ranges.back().first; i < ranges.back().second; i++) {
+            uint32_t track = index.words[i].track;
+            if (seen[track] != stamp) {
+                seen[track] = stamp;
+                results.push_back(track);
+            }
+        }
+        std::sort(results.begin(), results.end(), [this](uint32_t a, uint32_t b) {
+            return index.rank[a] < index.rank[b];
+        });
+    }
+
+    // Stay on the same track if it is still listed.
+    selected = 0;
+    if (hadSelection) {
+        auto it = std::lower_bound(results.begin(), results.end(), keep, [this](uint32_t a, uint32_t b) {
+            return index.rank[a] < index.rank[b];
+        });
+        if (it != results.end() && *it == keep)
+            selected = static_cast<size_t>(it - results.begin());
+    }
+    scrollToSelection = true;
+}
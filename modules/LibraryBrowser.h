@@ -0,0 +1,118 @@
+#ifndef LIBRARY_BROWSER_H
+#define LIBRARY_BROWSER_H
+
+#include "imgui.h"
+#include "TrackStore.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// On-screen list of the USB library, sorted by artist and title, that
+// narrows down as the user types.
+//
+// Search goes through a prefix index: every word of every artist and title,
+// case-folded and sorted, so the tracks matching a query are one contiguous
+// range found by binary search. Each typed character only searches within
+// the previous character's range; backspace pops back to it. Only the rows
+// on screen are drawn (ImGuiListClipper), so the cost of a frame does not
+// depend on the size of the library.
+//
+// The index is built on Open(), and rebuilt while open whenever the library
+// changes, without holding up the render thread: the text is copied out of
+// the store a slice per SetLibrary() call, and sorted on a worker thread.
+// Until the new index is ready the previous one stays in use. While the
+// browser is closed nothing is built.
+class LibraryBrowser {
+public:
+    LibraryBrowser();
+    ~LibraryBrowser();
+
+    void Open();
+    void Close();
+    bool IsOpen() const { return open; }
+
+    // Call on every wake-up, after the audio manager's Update(). 'version'
+    // changes whenever the store's existing indices change meaning; tracks
+    // appended under the same version are indexed at most once a second,
+    // and only while open. nullptr (no USB library) empties and closes the
+    // browser. Returns true when the open browser swapped in a new index,
+    // so the list needs redrawing.
+    bool SetLibrary(const TrackStore* store, unsigned long long version);
+    // A new index is being built; SetLibrary() calls move it along.
+    bool IsIndexing() const { return copying || sorter.joinable(); }
+
+    // Typed text (UTF-8) is added to the query; Erase() removes its last
+    // character. Edits made while the index is being rebuilt are kept and
+    // searched once the new index is in.
+    void Type(const char* text);
+    void Erase();
+    // Moves the selection by 'rows', clamped to the list.
+    void MoveSelection(int rows);
+    // Rows that fit on screen, for page up/down.
+    int GetPageRows() const { return pageRows; }
+    // The selected track, as an index into the store.
+    bool GetSelectedTrack(uint32_t& track) const;
+
+    // Draws the query line and the visible rows into a window at 'pos'.
+    void Draw(const ImVec2& pos, const ImVec2& size);
+
+private:
+    // A word start in Index::folded and the track it belongs to.
+    struct Word {
+        uint32_t offset;
+        uint32_t track;
+    };
+
+    struct Index {
+        std::string folded;          // Each artist and title lowercased, NUL-terminated
+        std::vector<Word> words;     // Sorted by the text from each word on
+        std::vector<uint32_t> sorted;    // Tracks by artist, then title
+        std::vector<uint32_t> rank;      // Position of each track in 'sorted'
+        std::vector<uint32_t> artistAt;  // Offsets in 'folded', for sorting
+        std::vector<uint32_t> titleAt;
+    };
+
+    void startBuild(size_t count);
+    void copySlice();
+    static void sortIndex(Index& built);
+    void adoptIndex();
+    void extendQuery(const char* text);
+    void refilter();
+
+    bool open;
+    const TrackStore* library;
+    unsigned long long libraryVersion;
+
+    // What searches and Draw() use. 'stale' once the library's indices
+    // changed meaning, until a new index is adopted.
+    Index index;
+    size_t indexedCount;
+    bool stale;
+
+    // The next index: filled by copySlice(), then sorted on 'sorter'.
+    Index building;
+    unsigned long long buildVersion;
+    size_t buildCount;
+    size_t buildNext;
+    bool copying;
+    std::thread sorter;
+    std::atomic<bool> sortDone;
+    std::chrono::steady_clock::time_point lastBuild;
+
+    // The query, and the range of index.words matching each prefix of it.
+    std::string query;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    std::vector<uint32_t> results;  // Empty query: all of index.sorted
+    std::vector<uint32_t> seen;     // Per track: stamp of the last refilter that found it
+    uint32_t stamp;
+
+    size_t selected;
+    bool scrollToSelection;
+    int pageRows;
+};
+
+#endif // LIBRARY_BROWSER_H
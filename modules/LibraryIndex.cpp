@@ -0,0 +1,233 @@
+#include "LibraryIndex.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On-disk layout. All fields are native-endian; the version doubles as the
+// byte-order check. Version 2 durations come from the MP3 headers, version 3
+// artists and titles from ID3 tags. The loudness took over a word that was
+// always written as 0, which reads as "not analysed", so version 3 files
+// stay valid.
+static const char INDEX_MAGIC[8] = { 'R', 'A', 'D', 'I', '0', 'I', 'D', 'X' };
+static const uint32_t INDEX_VERSION = 3;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t stringsSize;
+};
+
+struct IndexEntry {
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    uint32_t artistOffset;
+    uint32_t artistLength;
+    uint32_t titleOffset;
+    uint32_t titleLength;
+    float duration;
+    float loudness;
+    int64_t mtime;
+    int64_t size;
+};
+
+// Creates every missing directory leading up to 'file'.
+static void createParentDirectories(const std::string& file)
+{
+    for (size_t pos = file.find('/', 1); pos != std::string::npos; pos = file.find('/', pos + 1))
+        mkdir(file.substr(0, pos).c_str(), 0755);
+}
+
+LibraryIndex::LibraryIndex()
+    : data(nullptr),
+      dataSize(0),
+      count(0),
+      entries(nullptr),
+      strings(nullptr),
+      stringsSize(0)
+{
+}
+
+LibraryIndex::~LibraryIndex()
+{
+    Close();
+}
+
+bool LibraryIndex::Open(const std::string& file)
+{
+    Close();
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(IndexHeader))) {
+        close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    data = static_cast<const unsigned char*>(mapping);
+    dataSize = static_cast<size_t>(info.st_size);
+
+    IndexHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    uint64_t entriesSize = static_cast<uint64_t>(header.count) * sizeof(IndexEntry);
+    if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header.version != INDEX_VERSION ||
+        header.stringsSize > dataSize ||
+        sizeof(IndexHeader) + entriesSize + header.stringsSize != dataSize) {
+        std::cerr << "Ignoring invalid library index " << file << "\n";
+        Close();
+        return false;
+    }
+    count = header.count;
+    entries = data + sizeof(IndexHeader);
+    strings = reinterpret_cast<const char*>(entries + entriesSize);
+    stringsSize = static_cast<size_t>(header.stringsSize);
+
+    // Check every string once here so GetEntry() can trust the offsets.
+    for (size_t i = 0; i < count; ++i) {
+        IndexEntry entry;
+        std::memcpy(&entry, entries + i * sizeof(IndexEntry), sizeof(entry));
+        if (static_cast<uint64_t>(entry.pathOffset) + entry.pathLength > stringsSize ||
+            static_cast<uint64_t>(entry.artistOffset) + entry.artistLength > stringsSize ||
+            static_cast<uint64_t>(entry.titleOffset) + entry.titleLength > stringsSize) {
+            std::cerr << "Ignoring corrupt library index " << file << "\n";
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void LibraryIndex::Close()
+{
+    if (data)
+        munmap(const_cast<unsigned char*>(data), dataSize);
+    data = nullptr;
+    dataSize = 0;
+    count = 0;
+    entries = nullptr;
+    strings = nullptr;
+    stringsSize = 0;
+}
+
+LibraryIndex::Entry LibraryIndex::GetEntry(size_t index) const
+{
+    IndexEntry raw;
+    std::memcpy(&raw, entries + index * sizeof(IndexEntry), sizeof(raw));
+    Entry entry;
+    entry.path = std::string_view(strings + raw.pathOffset, raw.pathLength);
+    entry.artist = std::string_view(strings + raw.artistOffset, raw.artistLength);
+    entry.title = std::string_view(strings + raw.titleOffset, raw.titleLength);
+    entry.duration = raw.duration;
+    entry.loudness = raw.loudness;
+    entry.mtime = raw.mtime;
+    entry.size = raw.size;
+    return entry;
+}
+
+bool LibraryIndex::Find(std::string_view path, Entry& entry) const
+{
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        Entry candidate = GetEntry(mid);
+        int order = candidate.path.compare(path);
+        if (order == 0) {
+            entry = candidate;
+            return true;
+        }
+        if (order < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return false;
+}
+
+bool LibraryIndex::Write(const std::string& file, const std::string& root,
+                         const std::vector<TrackInfo>& tracks)
+{
+    // Strip the root (and the separator after it) from every path.
+    size_t prefix = root.size() + 1;
+    std::vector<const TrackInfo*> sorted;
+    sorted.reserve(tracks.size());
+    for (const TrackInfo& track : tracks) {
+        if (track.filePath.size() > prefix && track.filePath.compare(0, root.size(), root) == 0)
+            sorted.push_back(&track);
+    }
+    std::sort(sorted.begin(), sorted.end(), [prefix](const TrackInfo* a, const TrackInfo* b) {
+        return a->filePath.compare(prefix, std::string::npos, b->filePath, prefix, std::string::npos) < 0;
+    });
+
+    std::vector<IndexEntry> records;
+    std::string blob;
+    records.reserve(sorted.size());
+    // Strings are NUL-terminated in the blob so they can be passed to C APIs.
+    auto append = [&blob](const char* text, size_t length, uint32_t& offset, uint32_t& size) {
+        offset = static_cast<uint32_t>(blob.size());
+        size = static_cast<uint32_t>(length);
+        blob.append(text, length);
+        blob.push_back('\0');
+    };
+    for (const TrackInfo* track : sorted) {
+        IndexEntry record;
+        append(track->filePath.c_str() + prefix, track->filePath.size() - prefix,
+               record.pathOffset, record.pathLength);
+        append(track->artist.c_str(), track->artist.size(), record.artistOffset, record.artistLength);
+        append(track->title.c_str(), track->title.size(), record.titleOffset, record.titleLength);
+        record.duration = track->duration;
+        record.loudness = track->loudness;
+        record.mtime = track->mtime;
+        record.size = track->size;
+        records.push_back(record);
+    }
+
+    IndexHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.count = static_cast<uint32_t>(records.size());
+    header.stringsSize = blob.size();
+
+    createParentDirectories(file);
+    std::string temp = file + ".tmp";
+    FILE* out = fopen(temp.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Failed to write library index " << temp << "\n";
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              (records.empty() || fwrite(records.data(), sizeof(IndexEntry), records.size(), out) == records.size()) &&
+              (blob.empty() || fwrite(blob.data(), 1, blob.size(), out) == blob.size());
+    // The head unit loses power without warning; make the data durable
+    // before it replaces the old index.
+    ok = ok && fflush(out) == 0 && fsync(fileno(out)) == 0;
+    ok = (fclose(out) == 0) && ok;
+    if (!ok || rename(temp.c_str(), file.c_str()) != 0) {
+        std::cerr << "Failed to write library index " << file << "\n";
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string LibraryIndex::DefaultPath()
+{
+    if (const char* path = getenv("RADI0_LIBRARY_INDEX"))
+        return path;
+    if (const char* cache = getenv("XDG_CACHE_HOME"))
+        return std::string(cache) + "/radi0/library.idx";
+    const char* home = getenv("HOME");
+    return std::string(home ? home : "/tmp") + "/.cache/radi0/library.idx";
+}
@@ -0,0 +1,65 @@
+#ifndef LIBRARY_INDEX_H
+#define LIBRARY_INDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "TrackInfo.h"
+
+// Persistent index of the USB library, so startup does not have to walk and
+// parse the whole drive before the first track plays.
+//
+// The file is a flat little binary image that is mmap()ed read-only:
+//   header | entries[count] (sorted by path) | string blob
+// Paths are stored relative to the library root, so the index stays valid if
+// the drive is mounted elsewhere. Each entry keeps the file's mtime and size;
+// a rescan only re-parses files whose mtime or size changed. Loudness is
+// filled in later by the background analysis and rewritten as it goes.
+class LibraryIndex {
+public:
+    // A track as stored in the mapped file. The views point into the
+    // mapping and stay valid until Close().
+    struct Entry {
+        std::string_view path;      // Relative to the library root.
+        std::string_view artist;
+        std::string_view title;
+        float duration;
+        float loudness;             // LUFS, 0 if not analysed yet (see LOUDNESS_UNMEASURABLE).
+        long long mtime;
+        long long size;
+    };
+
+    LibraryIndex();
+    ~LibraryIndex();
+
+    // Maps and validates an index file. Returns false if it is missing,
+    // truncated or from another format version.
+    bool Open(const std::string& file);
+    void Close();
+
+    bool IsOpen() const { return data != nullptr; }
+    size_t GetCount() const { return count; }
+    Entry GetEntry(size_t index) const;
+    // Looks up a relative path (binary search).
+    bool Find(std::string_view path, Entry& entry) const;
+
+    // Writes tracks (whose filePath must start with root) to file. The file
+    // is written next to its final name and renamed, so readers never see a
+    // partial index.
+    static bool Write(const std::string& file, const std::string& root,
+                      const std::vector<TrackInfo>& tracks);
+
+    // $RADI0_LIBRARY_INDEX, or library.idx in the user's cache directory
+    // ($XDG_CACHE_HOME/radi0 or ~/.cache/radi0).
+    static std::string DefaultPath();
+
+private:
+    const unsigned char* data;
+    size_t dataSize;
+    size_t count;
+    const unsigned char* entries;
+    const char* strings;
+    size_t stringsSize;
+};
+
+#endif // LIBRARY_INDEX_H
@@ -0,0 +1,216 @@
+#include "LibraryScanner.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Shared state of one Run().
+struct ScanState {
+    int rootFd;
+    std::string root;
+    const std::vector<std::string>* extensions;
+    const LibraryScanner::BatchCallback* onBatch;
+    const std::atomic<bool>* cancel;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::string> directories;   // Relative paths still to read
+    unsigned busy;                          // Workers currently reading one
+
+    std::atomic<size_t> directoryCount;
+    std::atomic<size_t> fileCount;
+    std::atomic<size_t> matchedCount;
+};
+
+static bool isCancelled(const ScanState& scan)
+{
+    return scan.cancel && scan.cancel->load(std::memory_order_relaxed);
+}
+
+static bool hasExtension(const char* name, size_t length, const std::vector<std::string>& extensions)
+{
+    for (const std::string& extension : extensions) {
+        if (length <= extension.size())
+            continue;
+        const char* suffix = name + length - extension.size();
+        bool match = true;
+        for (size_t i = 0; i < extension.size() && match; i++)
+            match = std::tolower(static_cast<unsigned char>(suffix[i])) == extension[i];
+        if (match)
+            return true;
+    }
+    return false;
+}
+
+static long long modificationTime(const struct stat& info)
+{
+    return static_cast<long long>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+}
+
+// Reads one directory: subdirectories go to 'subdirectories', matching
+// files are passed to the batch callback.
+static void scanDirectory(ScanState& scan, const std::string& relative,
+                          std::vector<std::string>& subdirectories)
+{
+    int fd = openat(scan.rootFd, relative.empty() ? "." : relative.c_str(),
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    DIR* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return;
+    }
+    scan.directoryCount.fetch_add(1, std::memory_order_relaxed);
+
+    std::string prefix = relative.empty() ? std::string() : relative + "/";
+    std::vector<TrackInfo> batch;
+    size_t files = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr && !isCancelled(scan)) {
+        const char* name = entry->d_name;
+        if (name[0] == '.')
+            continue;
+        size_t length = strlen(name);
+        struct stat info;
+        if (entry->d_type == DT_DIR) {
+            subdirectories.push_back(prefix + name);
+            continue;
+        }
+        if (entry->d_type == DT_UNKNOWN) {
+            // Filesystem without d_type: one lstat tells both kinds apart.
+            if (fstatat(dirfd(dir), name, &info, AT_SYMLINK_NOFOLLOW) != 0)
+                continue;
+            if (S_ISDIR(info.st_mode)) {
+                subdirectories.push_back(prefix + name);
+                continue;
+            }
+        }
+        files++;
+        if (!hasExtension(name, length, *scan.extensions))
+            continue;
+        // Follow file symlinks, but only keep what resolves to a regular file.
+        if (fstatat(dirfd(dir), name, &info, 0) != 0 || !S_ISREG(info.st_mode))
+            continue;
+        TrackInfo track;
+        track.filePath = scan.root + "/" + prefix + name;
+        track.duration = 0.0f;
+        track.loudness = 0.0f;
+        track.mtime = modificationTime(info);
+        track.size = static_cast<long long>(info.st_size);
+        batch.push_back(std::move(track));
+    }
+    closedir(dir);
+
+    scan.fileCount.fetch_add(files, std::memory_order_relaxed);
+    if (!batch.empty()) {
+        scan.matchedCount.fetch_add(batch.size(), std::memory_order_relaxed);
+        (*scan.onBatch)(batch);
+    }
+}
+
+// Takes directories off the shared queue until it is empty and no other
+// worker can add to it any more.
+static void scanWorker(ScanState& scan)
+{
+    std::vector<std::string> subdirectories;
+    std::unique_lock<std::mutex> lock(scan.mutex);
+    for (;;) {
+        scan.wake.wait(lock, [&scan] {
+            return !scan.directories.empty() || scan.busy == 0 || isCancelled(scan);
+        });
+        if (scan.directories.empty() || isCancelled(scan))
+            break;
+        std::string relative = std::move(scan.directories.front());
+        scan.directories.pop_front();
+        scan.busy++;
+        lock.unlock();
+
+        subdirectories.clear();
+        scanDirectory(scan, relative, subdirectories);
+
+        lock.lock();
+        scan.busy--;
+        for (std::string& subdirectory : subdirectories)
+            scan.directories.push_back(std::move(subdirectory));
+        // Wake idle workers for new directories, or for the end of the walk.
+        scan.wake.notify_all();
+    }
+    scan.wake.notify_all();
+}
+
+double LibraryScanner::Stats::FilesPerSecond() const
+{
+    return (seconds > 0.0) ? files / seconds : 0.0;
+}
+
+LibraryScanner::LibraryScanner()
+    : extensions({ ".mp3" })
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    threadCount = std::clamp(cores, 1u, 4u);
+}
+
+void LibraryScanner::SetExtensions(const std::vector<std::string>& list)
+{
+    extensions.clear();
+    for (std::string extension : list) {
+        if (extension.empty())
+            continue;
+        if (extension[0] != '.')
+            extension.insert(extension.begin(), '.');
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        extensions.push_back(extension);
+    }
+}
+
+void LibraryScanner::SetThreadCount(unsigned count)
+{
+    threadCount = std::max(count, 1u);
+}
+
+bool LibraryScanner::Run(const std::string& root, const BatchCallback& onBatch,
+                         const std::atomic<bool>* cancel, Stats* stats) const
+{
+    auto start = std::chrono::steady_clock::now();
+    int rootFd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd < 0)
+        return false;
+
+    ScanState scan;
+    scan.rootFd = rootFd;
+    scan.root = root;
+    scan.extensions = &extensions;
+    scan.onBatch = &onBatch;
+    scan.cancel = cancel;
+    scan.busy = 0;
+    scan.directoryCount = 0;
+    scan.fileCount = 0;
+    scan.matchedCount = 0;
+    scan.directories.push_back(std::string());
+
+    std::vector<std::thread> helpers;
+    for (unsigned i = 1; i < threadCount; i++)
+        helpers.emplace_back(scanWorker, std::ref(scan));
+    scanWorker(scan);
+    for (std::thread& helper : helpers)
+        helper.join();
+    close(rootFd);
+
+    if (stats) {
+        stats->directories = scan.directoryCount;
+        stats->files = scan.fileCount;
+        stats->matched = scan.matchedCount;
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
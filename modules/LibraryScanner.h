@@ -0,0 +1,54 @@
+#ifndef LIBRARY_SCANNER_H
+#define LIBRARY_SCANNER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+#include "TrackInfo.h"
+
+// Recursive walk of a music library on a small pool of threads.
+//
+// Directories are queued as paths relative to the root and opened with
+// openat() against a single root descriptor; entries are stat()ed with
+// fstatat() relative to their directory, so no thread ever resolves a full
+// path. Matching files are handed out per directory as soon as that
+// directory has been read, so callers can start playback before the walk
+// completes.
+class LibraryScanner {
+public:
+    struct Stats {
+        size_t directories;
+        size_t files;       // Non-directory entries examined
+        size_t matched;     // Files that passed the extension filter
+        double seconds;
+
+        double FilesPerSecond() const;
+    };
+
+    // Receives the matching files of one directory. filePath, mtime and
+    // size are filled in; the rest of the TrackInfo is left to the caller.
+    // Called concurrently from the worker threads.
+    using BatchCallback = std::function<void(std::vector<TrackInfo>& batch)>;
+
+    LibraryScanner();
+
+    // File extensions to collect, with the dot (".mp3"). Matching ignores
+    // case. Defaults to ".mp3".
+    void SetExtensions(const std::vector<std::string>& extensions);
+    // Number of threads walking the tree, including the caller's.
+    // Defaults to the core count, capped at 4.
+    void SetThreadCount(unsigned count);
+
+    // Walks root and blocks until the walk is done or *cancel becomes true.
+    // Hidden entries (leading '.') are skipped and symlinked directories
+    // are not followed. Returns false if root cannot be opened.
+    bool Run(const std::string& root, const BatchCallback& onBatch,
+             const std::atomic<bool>* cancel, Stats* stats = nullptr) const;
+
+private:
+    std::vector<std::string> extensions;
+    unsigned threadCount;
+};
+
+#endif // LIBRARY_SCANNER_H
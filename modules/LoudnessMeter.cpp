@@ -0,0 +1,142 @@
+#include "LoudnessMeter.h"
+#include <cmath>
+
+static const double ABSOLUTE_GATE_LUFS = -70.0;
+static const double RELATIVE_GATE_LU = -10.0;
+
+// BS.1770 loudness of a mean square summed over the channels.
+static double loudnessOf(double power)
+{
+    return -0.691 + 10.0 * std::log10(power);
+}
+
+static double powerOf(double lufs)
+{
+    return std::pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+LoudnessMeter::LoudnessMeter(int sampleRate, int channelCount)
+    : channels(channelCount),
+      shelfState{ { 0.0, 0.0 }, { 0.0, 0.0 } },
+      highPassState{ { 0.0, 0.0 }, { 0.0, 0.0 } },
+      subBlockFrames(sampleRate > 0 ? static_cast<size_t>(sampleRate) / 10 : 0),
+      subBlockFill(0),
+      subBlockEnergy(0.0),
+      recentEnergy{ 0.0, 0.0, 0.0, 0.0 },
+      subBlocks(0)
+{
+    // BS.1770 gives the filters for 48 kHz; these are the analog
+    // prototypes behind them, re-derived for any rate.
+    double rate = sampleRate > 0 ? sampleRate : 48000.0;
+
+    double k = std::tan(M_PI * 1681.974450955533 / rate);
+    double q = 0.7071752369554196;
+    double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    shelf.b1 = 2.0 * (k * k - vh) / a0;
+    shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+    k = std::tan(M_PI * 38.13547087602444 / rate);
+    q = 0.5003270373238773;
+    a0 = 1.0 + k / q + k * k;
+    highPass.b0 = 1.0;
+    highPass.b1 = -2.0;
+    highPass.b2 = 1.0;
+    highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+    highPass.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+void LoudnessMeter::Process(const short* samples, size_t frames)
+{
+    if (subBlockFrames == 0)
+        return;
+    if (channels == 1)
+        processFrames<1>(samples, frames);
+    else if (channels == 2)
+        processFrames<2>(samples, frames);
+}
+
+bool LoudnessMeter::GetIntegratedLoudness(float& lufs) const
+{
+    double absoluteGate = powerOf(ABSOLUTE_GATE_LUFS);
+    double sum = 0.0;
+    size_t count = 0;
+    for (double power : blockPower) {
+        if (power > absoluteGate) {
+            sum += power;
+            count++;
+        }
+    }
+    if (count == 0)
+        return false;
+
+    double relativeGate = powerOf(loudnessOf(sum / count) + RELATIVE_GATE_LU);
+    double gatedSum = 0.0;
+    size_t gatedCount = 0;
+    for (double power : blockPower) {
+        if (power > absoluteGate && power > relativeGate) {
+            gatedSum += power;
+            gatedCount++;
+        }
+    }
+    if (gatedCount == 0)
+        return false;
+    lufs = static_cast<float>(loudnessOf(gatedSum / gatedCount));
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Private Helper Functions
+// -----------------------------------------------------------------------------
+
+// The channel loop has a fixed trip count, so both channels run through
+// each filter stage side by side.
+template <int Channels>
+void LoudnessMeter::processFrames(const short* samples, size_t frames)
+{
+    const double scale = 1.0 / 32768.0;
+    const Biquad s = shelf;
+    const Biquad h = highPass;
+    while (frames > 0) {
+        size_t run = subBlockFrames - subBlockFill;
+        if (run > frames)
+            run = frames;
+        double energy[Channels] = {};
+        for (size_t f = 0; f < run; f++) {
+            for (int c = 0; c < Channels; c++) {
+                double x = samples[f * Channels + c] * scale;
+                double y = s.b0 * x + shelfState[0][c];
+                shelfState[0][c] = s.b1 * x - s.a1 * y + shelfState[1][c];
+                shelfState[1][c] = s.b2 * x - s.a2 * y;
+                double z = h.b0 * y + highPassState[0][c];
+                highPassState[0][c] = h.b1 * y - h.a1 * z + highPassState[1][c];
+                highPassState[1][c] = h.b2 * y - h.a2 * z;
+                energy[c] += z * z;
+            }
+        }
+        for (int c = 0; c < Channels; c++)
+            subBlockEnergy += energy[c];
+        samples += run * Channels;
+        frames -= run;
+        subBlockFill += run;
+        if (subBlockFill == subBlockFrames)
+            endSubBlock();
+    }
+}
+
+// A 400 ms block ends with every 100 ms sub-block, once there are four.
+void LoudnessMeter::endSubBlock()
+{
+    recentEnergy[subBlocks % 4] = subBlockEnergy;
+    subBlocks++;
+    subBlockEnergy = 0.0;
+    subBlockFill = 0;
+    if (subBlocks >= 4) {
+        double energy = recentEnergy[0] + recentEnergy[1] + recentEnergy[2] + recentEnergy[3];
+        blockPower.push_back(energy / (4.0 * subBlockFrames));
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef LOUDNESS_METER_H
+#define LOUDNESS_METER_H
+
+#include <cstddef>
+#include <vector>
+
+// Integrated loudness of one track, per EBU R128 / ITU-R BS.1770.
+//
+// Samples are K-weighted (a high shelf and a high-pass biquad), their
+// energy is summed over 400 ms blocks overlapping by 75%, and the blocks
+// are gated: first at -70 LUFS, then 10 LU below the loudness of what is
+// left. Mono and stereo only; both channels are filtered in lockstep so
+// the compiler can keep them in one SIMD register.
+class LoudnessMeter {
+public:
+    LoudnessMeter(int sampleRate, int channels);
+
+    // Feeds interleaved signed 16-bit frames.
+    void Process(const short* samples, size_t frames);
+
+    // Returns false if nothing above the absolute gate was heard (silence,
+    // or less than one 400 ms block).
+    bool GetIntegratedLoudness(float& lufs) const;
+
+    // Unsupported channel counts measure nothing.
+    bool IsValid() const { return channels == 1 || channels == 2; }
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    template <int Channels>
+    void processFrames(const short* samples, size_t frames);
+    void endSubBlock();
+
+    int channels;
+    Biquad shelf;
+    Biquad highPass;
+    // Transposed direct form II state, per stage and channel.
+    double shelfState[2][2];
+    double highPassState[2][2];
+
+    size_t subBlockFrames;     // 100 ms
+    size_t subBlockFill;
+    double subBlockEnergy;
+    double recentEnergy[4];    // Last four sub-blocks, summed into a block
+    size_t subBlocks;
+    std::vector<double> blockPower;   // Mean square of each 400 ms block
+};
+
+#endif // LOUDNESS_METER_H
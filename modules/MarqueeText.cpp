@@ -0,0 +1,84 @@
+#include "MarqueeText.h"
+#include <cstring>
+
+MarqueeText::MarqueeText()
+    : fontSize(0.0f),
+      size(0.0f, 0.0f),
+      scrollOffset(0.0f)
+{
+}
+
+void MarqueeText::SetText(const char* new_text, float font_size)
+{
+    if (font_size == fontSize && text == new_text)
+        return;
+    text = new_text;
+    fontSize = font_size;
+    scrollOffset = 0.0f;
+
+    // Measure like ImGui::CalcTextSize() so the clip rect matches what
+    // ImGui::TextUnformatted() would produce.
+    ImFont* font = ImGui::GetFont();
+    size = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, text.c_str());
+    size.x = static_cast<float>(static_cast<int>(size.x + 0.99999f));
+
+    // Let ImGui lay out the glyphs once at the origin and keep the quads.
+    ImDrawList scratch(ImGui::GetDrawListSharedData());
+    scratch._ResetForNewFrame();
+    scratch.PushTextureID(font->ContainerAtlas->TexID);
+    scratch.PushClipRect(ImVec2(-1.0e6f, -1.0e6f), ImVec2(1.0e6f, 1.0e6f));
+    scratch.AddText(font, fontSize, ImVec2(0.0f, 0.0f), ImGui::GetColorU32(ImGuiCol_Text), text.c_str());
+    quads.assign(scratch.VtxBuffer.begin(), scratch.VtxBuffer.end());
+}
+
+void MarqueeText::Scroll(float distance, float region_width)
+{
+    if (!IsScrolling(region_width)) {
+        scrollOffset = 0.0f;
+        return;
+    }
+    scrollOffset += distance;
+    if (scrollOffset > size.x)
+        scrollOffset = -region_width;
+}
+
+void MarqueeText::Draw(ImDrawList* draw_list, const ImVec2& pos, float region_width,
+                       bool anchor_end) const
+{
+    if (quads.empty())
+        return;
+
+    float x = pos.x - scrollOffset;
+    if (anchor_end && size.x > region_width)
+        x -= size.x - region_width;
+    // ImGui snaps the text origin the same way.
+    ImVec2 origin(static_cast<float>(static_cast<int>(x)), static_cast<float>(static_cast<int>(pos.y)));
+
+    ImVec2 clip_max(pos.x + region_width, pos.y + size.y);
+    draw_list->PushClipRect(pos, clip_max, true);
+    const ImVec4& clip = draw_list->_CmdHeader.ClipRect;
+
+    int glyph_count = static_cast<int>(quads.size() / 4);
+    draw_list->PrimReserve(glyph_count * 6, glyph_count * 4);
+    int emitted = 0;
+    for (int i = 0; i < glyph_count; ++i) {
+        const ImDrawVert* quad = &quads[i * 4];
+        // Skip glyphs that are scrolled out of the region (ImGui does the same).
+        if (quad[0].pos.x + origin.x > clip.z || quad[2].pos.x + origin.x < clip.x)
+            continue;
+        ImDrawIdx base = static_cast<ImDrawIdx>(draw_list->_VtxCurrentIdx);
+        for (int v = 0; v < 4; ++v) {
+            ImVec2 p(quad[v].pos.x + origin.x, quad[v].pos.y + origin.y);
+            draw_list->PrimWriteVtx(p, quad[v].uv, quad[v].col);
+        }
+        draw_list->PrimWriteIdx(base);
+        draw_list->PrimWriteIdx(static_cast<ImDrawIdx>(base + 1));
+        draw_list->PrimWriteIdx(static_cast<ImDrawIdx>(base + 2));
+        draw_list->PrimWriteIdx(base);
+        draw_list->PrimWriteIdx(static_cast<ImDrawIdx>(base + 2));
+        draw_list->PrimWriteIdx(static_cast<ImDrawIdx>(base + 3));
+        emitted++;
+    }
+    draw_list->PrimUnreserve((glyph_count - emitted) * 6, (glyph_count - emitted) * 4);
+    draw_list->PopClipRect();
+}
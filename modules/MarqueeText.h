@@ -0,0 +1,41 @@
+#ifndef MARQUEE_TEXT_H
+#define MARQUEE_TEXT_H
+
+#include "imgui.h"
+#include <string>
+#include <vector>
+
+// A single line of text that scrolls horizontally when it does not fit its
+// region. The string is measured and laid out into glyph quads only when it
+// (or the font size) changes; every other frame just emits the cached quads
+// at the current scroll offset.
+class MarqueeText {
+public:
+    MarqueeText();
+
+    // Relayouts the text if it differs from the cached one, which also resets
+    // the scroll position. Must be called inside an ImGui frame.
+    void SetText(const char* text, float font_size);
+
+    // Advances the scroll position by 'distance' pixels if the text is wider
+    // than the region; wraps around once it has scrolled out completely.
+    void Scroll(float distance, float region_width);
+
+    // Draws the visible part of the text clipped to the region starting at
+    // 'pos'. With 'anchor_end' an overflowing text starts with its end
+    // aligned to the region's end instead of its start.
+    void Draw(ImDrawList* draw_list, const ImVec2& pos, float region_width,
+              bool anchor_end) const;
+
+    bool IsScrolling(float region_width) const { return size.x > region_width; }
+    const ImVec2& GetSize() const { return size; }
+
+private:
+    std::string text;
+    float fontSize;
+    ImVec2 size;                    // Same as ImGui::CalcTextSize().
+    std::vector<ImDrawVert> quads;  // Four vertices per glyph, relative to the text origin.
+    float scrollOffset;
+};
+
+#endif // MARQUEE_TEXT_H
@@ -0,0 +1,65 @@
+#include "MixMonitor.h"
+
+MixMonitor::MixMonitor()
+    : bytesPerSecond(0.0),
+      lastCounter(0),
+      mixed(0),
+      late(0),
+      ring(),
+      written(0),
+      read(0)
+{
+}
+
+void MixMonitor::Start(double outputBytesPerSecond)
+{
+    bytesPerSecond = outputBytesPerSecond;
+    lastCounter = 0;
+    mixed.store(0);
+    late.store(0);
+    written.store(0);
+    read = 0;
+}
+
+void MixMonitor::OnMixed(int length)
+{
+    mixed.fetch_add(1, std::memory_order_relaxed);
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (lastCounter != 0 && bytesPerSecond > 0.0) {
+        double elapsed = static_cast<double>(now - lastCounter) / SDL_GetPerformanceFrequency();
+        double period = length / bytesPerSecond;
+        if (elapsed > 2.0 * period) {
+            late.fetch_add(1, std::memory_order_relaxed);
+            unsigned long long index = written.load(std::memory_order_relaxed);
+            Sample& sample = ring[index % CAPACITY];
+            sample.counter = now;
+            sample.lateMs = static_cast<float>((elapsed - period) * 1000.0);
+            written.store(index + 1, std::memory_order_release);
+        }
+    }
+    lastCounter = now;
+}
+
+unsigned long long MixMonitor::GetMixedPeriods() const
+{
+    return mixed.load(std::memory_order_relaxed);
+}
+
+unsigned long long MixMonitor::GetLatePeriods() const
+{
+    return late.load(std::memory_order_relaxed);
+}
+
+bool MixMonitor::PollUnderrun(double& time, float& lateMs)
+{
+    unsigned long long total = written.load(std::memory_order_acquire);
+    if (read == total)
+        return false;
+    if (total - read > CAPACITY)
+        read = total - CAPACITY;
+    const Sample& sample = ring[read % CAPACITY];
+    read++;
+    time = static_cast<double>(sample.counter) / SDL_GetPerformanceFrequency();
+    lateMs = sample.lateMs;
+    return true;
+}
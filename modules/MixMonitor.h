@@ -0,0 +1,51 @@
+#ifndef MIX_MONITOR_H
+#define MIX_MONITOR_H
+
+#include <SDL.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Watches SDL_mixer's post-mix callbacks for underruns.
+//
+// The device holds at least two periods, so a callback arriving more than
+// two periods after the previous one means the device ran dry: it is
+// counted as a late period (heard as a crackle) and queued for the UI
+// thread. OnMixed() runs on the audio thread, PollUnderrun() on one reader
+// thread; if the reader falls a whole ring behind, the oldest are dropped.
+class MixMonitor {
+public:
+    MixMonitor();
+
+    // Resets the counts for a newly opened device playing 'bytesPerSecond'.
+    // Call before the post-mix hook is installed.
+    void Start(double bytesPerSecond);
+
+    // From the post-mix hook, with the length of the chunk just mixed.
+    void OnMixed(int length);
+
+    unsigned long long GetMixedPeriods() const;
+    unsigned long long GetLatePeriods() const;
+
+    // The oldest late period not polled yet: when it was noticed, as
+    // SDL_GetPerformanceCounter() in seconds (an arbitrary epoch, not SDL
+    // start-up), and how far past one period it came.
+    bool PollUnderrun(double& time, float& lateMs);
+
+private:
+    struct Sample {
+        Uint64 counter;
+        float lateMs;
+    };
+    static constexpr size_t CAPACITY = 64;
+
+    double bytesPerSecond;
+    Uint64 lastCounter;                        // Audio thread only
+    std::atomic<unsigned long long> mixed;
+    std::atomic<unsigned long long> late;
+    std::array<Sample, CAPACITY> ring;
+    std::atomic<unsigned long long> written;   // Total ever written
+    unsigned long long read;                   // Reader thread only
+};
+
+#endif // MIX_MONITOR_H
@@ -0,0 +1,169 @@
+#include "MountWatcher.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+static const char* MOUNTINFO_PATH = "/proc/self/mountinfo";
+
+// mountinfo escapes spaces, tabs, newlines and backslashes as \ooo.
+static std::string unescapeMountPath(const std::string& field)
+{
+    std::string out;
+    out.reserve(field.size());
+    for (size_t i = 0; i < field.size(); i++) {
+        if (field[i] == '\\' && i + 3 < field.size()) {
+            int value = 0;
+            bool octal = true;
+            for (size_t j = 1; j <= 3 && octal; j++) {
+                char c = field[i + j];
+                octal = c >= '0' && c <= '7';
+                value = value * 8 + (c - '0');
+            }
+            if (octal) {
+                out.push_back(static_cast<char>(value));
+                i += 3;
+                continue;
+            }
+        }
+        out.push_back(field[i]);
+    }
+    return out;
+}
+
+// Reads the whole mount table from an open mountinfo descriptor.
+static std::string readMountTable(int fd)
+{
+    std::string table;
+    char buffer[4096];
+    if (lseek(fd, 0, SEEK_SET) < 0)
+        return table;
+    ssize_t got;
+    while ((got = read(fd, buffer, sizeof(buffer))) > 0)
+        table.append(buffer, static_cast<size_t>(got));
+    return table;
+}
+
+// The mount point is the fifth space-separated field of each line.
+static bool tableHasMountPoint(const std::string& table, const std::string& path)
+{
+    size_t line = 0;
+    while (line < table.size()) {
+        size_t end = table.find('\n', line);
+        if (end == std::string::npos)
+            end = table.size();
+        size_t field = line;
+        for (int i = 0; i < 4 && field < end; i++) {
+            field = table.find(' ', field);
+            if (field == std::string::npos || field >= end)
+                break;
+            field++;
+        }
+        size_t fieldEnd = table.find(' ', field);
+        if (field < end && fieldEnd != std::string::npos && fieldEnd < end &&
+            unescapeMountPath(table.substr(field, fieldEnd - field)) == path)
+            return true;
+        line = end + 1;
+    }
+    return false;
+}
+
+MountWatcher::MountWatcher()
+    : mountsFd(-1),
+      wakePipe{ -1, -1 },
+      eventType(0),
+      mounted(false)
+{
+}
+
+MountWatcher::~MountWatcher()
+{
+    Stop();
+}
+
+bool MountWatcher::Start(const std::string& mountPath)
+{
+    Stop();
+    path = mountPath;
+    if (eventType == 0) {
+        eventType = SDL_RegisterEvents(1);
+        if (eventType == static_cast<Uint32>(-1)) {
+            eventType = 0;
+            return false;
+        }
+    }
+    mountsFd = open(MOUNTINFO_PATH, O_RDONLY | O_CLOEXEC);
+    if (mountsFd < 0) {
+        printf("Mount watcher: cannot open %s.\n", MOUNTINFO_PATH);
+        return false;
+    }
+    if (pipe2(wakePipe, O_CLOEXEC) != 0) {
+        close(mountsFd);
+        mountsFd = -1;
+        return false;
+    }
+    mounted.store(tableHasMountPoint(readMountTable(mountsFd), path));
+    thread = std::thread(&MountWatcher::run, this);
+    return true;
+}
+
+void MountWatcher::Stop()
+{
+    if (thread.joinable()) {
+        char wake = 1;
+        ssize_t written = write(wakePipe[1], &wake, 1);
+        (void)written;
+        thread.join();
+    }
+    for (int& fd : wakePipe) {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+    if (mountsFd >= 0)
+        close(mountsFd);
+    mountsFd = -1;
+}
+
+bool MountWatcher::IsMountPoint(const std::string& mountPath)
+{
+    int fd = open(MOUNTINFO_PATH, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    bool found = tableHasMountPoint(readMountTable(fd), mountPath);
+    close(fd);
+    return found;
+}
+
+// Runs on the watcher thread. The kernel reports a mount table change on
+// mountinfo as POLLPRI | POLLERR.
+void MountWatcher::run()
+{
+    for (;;) {
+        struct pollfd fds[2];
+        fds[0].fd = mountsFd;
+        fds[0].events = POLLPRI;
+        fds[1].fd = wakePipe[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (fds[1].revents)
+            return;
+        if (!(fds[0].revents & (POLLPRI | POLLERR)))
+            continue;
+
+        bool now = tableHasMountPoint(readMountTable(mountsFd), path);
+        if (now == mounted.exchange(now))
+            continue;
+        printf("Mount watcher: %s %s.\n", path.c_str(), now ? "mounted" : "unmounted");
+        SDL_Event event;
+        SDL_zero(event);
+        event.type = eventType;
+        event.user.code = now ? Mounted : Unmounted;
+        SDL_PushEvent(&event);
+    }
+}
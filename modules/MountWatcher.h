@@ -0,0 +1,45 @@
+#ifndef MOUNT_WATCHER_H
+#define MOUNT_WATCHER_H
+
+#include <SDL.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+// Notices a USB stick being mounted or unmounted at one path.
+//
+// A background thread blocks in poll() on /proc/self/mountinfo, which the
+// kernel flags whenever the mount table changes, and re-reads the table
+// only then. Transitions are posted to the SDL event queue as an event of
+// GetEventType() with user.code set to Mounted or Unmounted, so the main
+// loop handles them like input and never polls the path itself.
+class MountWatcher {
+public:
+    enum EventCode { Mounted = 1, Unmounted = 2 };
+
+    MountWatcher();
+    ~MountWatcher();
+
+    // Starts watching; returns false if mountinfo cannot be watched.
+    bool Start(const std::string& mountPath);
+    void Stop();
+
+    Uint32 GetEventType() const { return eventType; }
+    // State as of the last mount table change seen.
+    bool IsMounted() const { return mounted.load(); }
+
+    // Whether 'path' is a mount point in the current mount table.
+    static bool IsMountPoint(const std::string& path);
+
+private:
+    void run();
+
+    std::string path;
+    std::thread thread;
+    int mountsFd;
+    int wakePipe[2];   // Written by Stop() to end the poll()
+    Uint32 eventType;
+    std::atomic<bool> mounted;
+};
+
+#endif // MOUNT_WATCHER_H
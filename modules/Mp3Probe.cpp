@@ -0,0 +1,180 @@
+#include "Mp3Probe.h"
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// How much audio is searched for the first frame, and read from the end of
+// the file for trailing tags.
+static const size_t HEAD_BYTES = 16 * 1024;
+static const size_t TAIL_BYTES = 4 * 1024;
+
+struct FrameHeader {
+    int version;        // 1 = MPEG-1, 2 = MPEG-2, 25 = MPEG-2.5
+    int layer;          // 1..3
+    int bitrate;        // bits per second
+    int sampleRate;
+    int samplesPerFrame;
+    int length;         // bytes, including the header
+    bool mono;
+};
+
+static uint32_t readBigEndian32(const unsigned char* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static uint32_t readLittleEndian32(const unsigned char* p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static bool parseFrameHeader(const unsigned char* p, FrameHeader& header)
+{
+    static const int BITRATES[5][15] = {
+        { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },  // MPEG-1 layer I
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },     // MPEG-1 layer II
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },      // MPEG-1 layer III
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },     // MPEG-2/2.5 layer I
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },          // MPEG-2/2.5 layer II/III
+    };
+    static const int SAMPLE_RATES[3] = { 44100, 48000, 32000 };
+
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0)
+        return false;
+    int versionBits = (p[1] >> 3) & 3;
+    int layerBits = (p[1] >> 1) & 3;
+    int bitrateIndex = p[2] >> 4;
+    int sampleRateIndex = (p[2] >> 2) & 3;
+    // Reserved version/layer/sample rate, and free-format or bad bitrates.
+    if (versionBits == 1 || layerBits == 0 || sampleRateIndex == 3 ||
+        bitrateIndex == 0 || bitrateIndex == 15)
+        return false;
+
+    header.version = (versionBits == 3) ? 1 : (versionBits == 2) ? 2 : 25;
+    header.layer = 4 - layerBits;
+    int table = (header.version == 1) ? header.layer - 1 : (header.layer == 1) ? 3 : 4;
+    header.bitrate = BITRATES[table][bitrateIndex] * 1000;
+    header.sampleRate = SAMPLE_RATES[sampleRateIndex] >> ((header.version == 1) ? 0 : (header.version == 2) ? 1 : 2);
+    header.mono = (p[3] >> 6) == 3;
+
+    int padding = (p[2] >> 1) & 1;
+    if (header.layer == 1) {
+        header.samplesPerFrame = 384;
+        header.length = (12 * header.bitrate / header.sampleRate + padding) * 4;
+    } else {
+        header.samplesPerFrame = (header.layer == 3 && header.version != 1) ? 576 : 1152;
+        header.length = header.samplesPerFrame / 8 * header.bitrate / header.sampleRate + padding;
+    }
+    return header.length > 4;
+}
+
+static bool sameStream(const FrameHeader& a, const FrameHeader& b)
+{
+    return a.version == b.version && a.layer == b.layer && a.sampleRate == b.sampleRate;
+}
+
+// Frame count from a Xing/Info or VBRI header inside the first frame, or 0.
+static uint32_t readVbrFrameCount(const unsigned char* frame, size_t available, const FrameHeader& header)
+{
+    // Xing/Info follows the side information.
+    size_t sideInfo = (header.version == 1) ? (header.mono ? 17 : 32) : (header.mono ? 9 : 17);
+    size_t xing = 4 + sideInfo;
+    if (xing + 12 <= available &&
+        (std::memcmp(frame + xing, "Xing", 4) == 0 || std::memcmp(frame + xing, "Info", 4) == 0)) {
+        uint32_t flags = readBigEndian32(frame + xing + 4);
+        if (flags & 1)
+            return readBigEndian32(frame + xing + 8);
+    }
+    // VBRI sits at a fixed offset: tag, version, delay, quality, bytes, frames.
+    size_t vbri = 4 + 32;
+    if (vbri + 18 <= available && std::memcmp(frame + vbri, "VBRI", 4) == 0)
+        return readBigEndian32(frame + vbri + 14);
+    return 0;
+}
+
+// Bytes of ID3v1 and APEv2 tags at the end of the file.
+static long long trailingTagBytes(int fd, long long fileSize)
+{
+    unsigned char tail[TAIL_BYTES];
+    size_t length = static_cast<size_t>(fileSize < static_cast<long long>(TAIL_BYTES) ? fileSize : TAIL_BYTES);
+    if (pread(fd, tail, length, fileSize - length) != static_cast<ssize_t>(length))
+        return 0;
+    long long tags = 0;
+    size_t end = length;
+    if (end >= 128 && std::memcmp(tail + end - 128, "TAG", 3) == 0) {
+        tags += 128;
+        end -= 128;
+    }
+    if (end >= 32 && std::memcmp(tail + end - 32, "APETAGEX", 8) == 0) {
+        const unsigned char* footer = tail + end - 32;
+        // Size covers the items and footer; the optional header adds 32.
+        long long size = readLittleEndian32(footer + 12);
+        if (readLittleEndian32(footer + 20) & 0x80000000u)
+            size += 32;
+        tags += size;
+    }
+    return tags;
+}
+
+bool ProbeMp3Duration(const std::string& path, float& duration)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    long long fileSize = static_cast<long long>(info.st_size);
+
+    // Skip an ID3v2 tag; its size is stored as a 28-bit syncsafe integer.
+    long long audioStart = 0;
+    unsigned char id3[10];
+    if (pread(fd, id3, sizeof(id3), 0) == static_cast<ssize_t>(sizeof(id3)) &&
+        std::memcmp(id3, "ID3", 3) == 0) {
+        audioStart = 10 + ((id3[6] & 0x7F) << 21 | (id3[7] & 0x7F) << 14 | (id3[8] & 0x7F) << 7 | (id3[9] & 0x7F));
+        if (id3[5] & 0x10)
+            audioStart += 10;   // Footer
+    }
+
+    unsigned char head[HEAD_BYTES];
+    ssize_t headLength = pread(fd, head, sizeof(head), audioStart);
+    if (headLength < 4) {
+        close(fd);
+        return false;
+    }
+    size_t available = static_cast<size_t>(headLength);
+
+    // First frame header whose successor (when it is within reach) agrees
+    // with it, so stray 0xFF bytes in the data are not taken for a sync.
+    size_t offset = 0;
+    FrameHeader header;
+    bool found = false;
+    for (; offset + 4 <= available; offset++) {
+        if (!parseFrameHeader(head + offset, header))
+            continue;
+        size_t next = offset + header.length;
+        FrameHeader following;
+        if (next + 4 > available || (parseFrameHeader(head + next, following) && sameStream(header, following))) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        close(fd);
+        return false;
+    }
+
+    uint32_t frames = readVbrFrameCount(head + offset, available - offset, header);
+    if (frames > 0) {
+        duration = static_cast<float>(static_cast<double>(frames) * header.samplesPerFrame / header.sampleRate);
+    } else {
+        long long audioBytes = fileSize - (audioStart + static_cast<long long>(offset)) - trailingTagBytes(fd, fileSize);
+        duration = (audioBytes > 0) ? static_cast<float>(audioBytes * 8.0 / header.bitrate) : 0.0f;
+    }
+    close(fd);
+    return duration > 0.0f;
+}
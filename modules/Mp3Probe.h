@@ -0,0 +1,17 @@
+#ifndef MP3_PROBE_H
+#define MP3_PROBE_H
+
+#include <string>
+
+// Reads the playing time of an MP3 from its headers, touching only the
+// start and end of the file.
+//
+// VBR files are timed from the frame count in their Xing/Info or VBRI
+// header. Files without one are treated as CBR: the first frame header
+// (checked against the one after it) gives the bitrate, and the audio
+// size excludes the ID3v2 tag at the front and any ID3v1 tag at the end.
+//
+// Returns false if no MPEG audio frame is found near the start.
+bool ProbeMp3Duration(const std::string& path, float& duration);
+
+#endif // MP3_PROBE_H
@@ -0,0 +1,138 @@
+#include "RenderScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+RenderScheduler::RenderScheduler()
+    : refreshRate(60.0),
+      progressResolution(0.0f),
+      dirty(true),               // Always draw the first frame.
+      animationRequested(false),
+      lastTickTime(0.0),
+      lastRenderTime(0.0),
+      renderedFrames(0),
+      skippedFrames(0),
+      lastState(PlaybackState::Stopped),
+      lastVolume(-1),
+      lastProgressStep(-1),
+      lastVersion(0)
+{
+}
+
+void RenderScheduler::Initialize(int refresh_rate)
+{
+    // SDL reports 0 when the refresh rate is unknown.
+    refreshRate = (refresh_rate > 0) ? static_cast<double>(refresh_rate) : 60.0;
+    lastTickTime = Now();
+    lastRenderTime = lastTickTime;
+}
+
+void RenderScheduler::SetProgressResolution(float pixels)
+{
+    progressResolution = pixels;
+}
+
+bool RenderScheduler::WaitForEvent(SDL_Event& event)
+{
+    int got;
+    if (ShouldRender()) {
+        // A frame is due anyway; just drain what is queued.
+        got = SDL_PollEvent(&event);
+    } else {
+        got = SDL_WaitEventTimeout(&event, IDLE_WAKE_MS);
+    }
+    if (got)
+        dirty = true;
+    return got != 0;
+}
+
+float RenderScheduler::Tick()
+{
+    double now = Now();
+    float delta = static_cast<float>(now - lastTickTime);
+    lastTickTime = now;
+    return delta;
+}
+
+void RenderScheduler::ObserveAudio(const PlaybackSnapshot& snapshot)
+{
+    int progressStep = static_cast<int>(snapshot.fraction * progressResolution);
+
+    if (snapshot.state != lastState || snapshot.volume != lastVolume ||
+        progressStep != lastProgressStep || snapshot.version != lastVersion) {
+        dirty = true;
+        lastState = snapshot.state;
+        lastVolume = snapshot.volume;
+        lastProgressStep = progressStep;
+        lastVersion = snapshot.version;
+    }
+}
+
+void RenderScheduler::RequestFrame()
+{
+    dirty = true;
+}
+
+void RenderScheduler::RequestAnimationFrame()
+{
+    animationRequested = true;
+}
+
+float RenderScheduler::AnimationDelta() const
+{
+    if (!animationRequested)
+        return 0.0f;
+    float delta = static_cast<float>(Now() - lastRenderTime);
+    return std::min(delta, MAX_ANIMATION_DELTA);
+}
+
+bool RenderScheduler::ShouldRender() const
+{
+    return dirty || animationRequested;
+}
+
+void RenderScheduler::FrameRendered()
+{
+    double now = Now();
+    skippedFrames += SkippedSince(lastRenderTime, now);
+    lastRenderTime = now;
+    renderedFrames++;
+    dirty = false;
+    animationRequested = false;
+}
+
+unsigned long long RenderScheduler::GetRenderedFrames() const
+{
+    return renderedFrames;
+}
+
+unsigned long long RenderScheduler::GetSkippedFrames() const
+{
+    // Include the idle time since the last frame we presented.
+    return skippedFrames + SkippedSince(lastRenderTime, Now());
+}
+
+void RenderScheduler::PrintStats() const
+{
+    unsigned long long skipped = GetSkippedFrames();
+    unsigned long long total = renderedFrames + skipped;
+    double percent = (total > 0) ? (100.0 * skipped / total) : 0.0;
+    printf("Render scheduler: %llu frame(s) rendered, %llu skipped (%.1f%% idle).\n",
+           renderedFrames, skipped, percent);
+}
+
+// -----------------------------------------------------------------------------
+// Private Helper Functions
+// -----------------------------------------------------------------------------
+double RenderScheduler::Now() const
+{
+    return static_cast<double>(SDL_GetPerformanceCounter()) /
+           static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// Number of vsync intervals between two presented frames that were not drawn.
+unsigned long long RenderScheduler::SkippedSince(double last_render, double now) const
+{
+    double intervals = std::floor((now - last_render) * refreshRate + 0.5);
+    return (intervals > 1.0) ? static_cast<unsigned long long>(intervals) - 1 : 0;
+}
@@ -0,0 +1,78 @@
+#ifndef RENDER_SCHEDULER_H
+#define RENDER_SCHEDULER_H
+
+#include <SDL.h>
+#include "IAudioManager.h"
+
+// Decides when the main loop actually has to build and present a frame.
+// Instead of redrawing every vsync, the loop blocks in SDL_WaitEventTimeout()
+// and only renders when input arrives, the audio manager's visible state
+// changes, or a running animation asked for the next frame.
+class RenderScheduler {
+public:
+    RenderScheduler();
+
+    // refresh_rate (Hz) is used to express idle time as skipped vsync frames.
+    void Initialize(int refresh_rate);
+
+    // Number of pixels the progress line spans; the sprite is only redrawn
+    // when playback has advanced by at least one of them.
+    void SetProgressResolution(float pixels);
+
+    // Blocks until an event arrives or the next wake-up is due.
+    // Returns true and fills 'event' if an event is pending.
+    bool WaitForEvent(SDL_Event& event);
+
+    // Seconds elapsed since the previous call. Use this instead of
+    // io.DeltaTime for work that also runs on idle wake-ups.
+    float Tick();
+
+    // Seconds to advance animations by in the frame about to be drawn: the
+    // time since the previous frame if that one asked to keep animating,
+    // clamped to MAX_ANIMATION_DELTA, and 0 on the first frame after idle.
+    // io.DeltaTime spans the whole idle period instead.
+    float AnimationDelta() const;
+
+    // Marks the frame dirty if anything the UI draws from the audio manager
+    // (state, volume, metadata, sprite position) has changed.
+    void ObserveAudio(const PlaybackSnapshot& snapshot);
+
+    // Redraw once as soon as possible.
+    void RequestFrame();
+    // Keep drawing at the display rate (marquee, particles, ...).
+    void RequestAnimationFrame();
+
+    bool ShouldRender() const;
+    void FrameRendered();
+
+    unsigned long long GetRenderedFrames() const;
+    unsigned long long GetSkippedFrames() const;
+    void PrintStats() const;
+
+private:
+    double Now() const;
+    unsigned long long SkippedSince(double last_render, double now) const;
+
+    // Longest time we sleep without checking the audio manager.
+    static constexpr int IDLE_WAKE_MS = 100;
+    // Longest step an animation takes, however late its frame is.
+    static constexpr float MAX_ANIMATION_DELTA = 1.0f / 30.0f;
+
+    double refreshRate;
+    float progressResolution;
+    bool dirty;
+    bool animationRequested;
+
+    double lastTickTime;
+    double lastRenderTime;
+    unsigned long long renderedFrames;
+    unsigned long long skippedFrames;
+
+    // Last observed audio state.
+    PlaybackState lastState;
+    int lastVolume;
+    int lastProgressStep;
+    unsigned long long lastVersion;
+};
+
+#endif // RENDER_SCHEDULER_H
@@ -0,0 +1,91 @@
+#include "RenderTarget.h"
+#include <iostream>
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+RenderTarget::RenderTarget()
+    : framebuffer(0),
+      texture(0),
+      width(0),
+      height(0),
+      previousFramebuffer(0),
+      previousViewport{0, 0, 0, 0}
+{
+}
+
+RenderTarget::~RenderTarget()
+{
+    Destroy();
+}
+
+bool RenderTarget::Create(int w, int h, bool linear_filter)
+{
+    Destroy();
+    if (w <= 0 || h <= 0)
+        return false;
+
+    GLint lastTexture = 0;
+    GLint lastFramebuffer = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &lastFramebuffer);
+
+    GLint filter = linear_filter ? GL_LINEAR : GL_NEAREST;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    glBindTexture(GL_TEXTURE_2D, lastTexture);
+    glBindFramebuffer(GL_FRAMEBUFFER, lastFramebuffer);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer " << w << "x" << h << " is incomplete (0x"
+                  << std::hex << status << std::dec << ").\n";
+        Destroy();
+        return false;
+    }
+    width = w;
+    height = h;
+    return true;
+}
+
+void RenderTarget::Destroy()
+{
+    if (framebuffer) {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+    if (texture) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    width = 0;
+    height = 0;
+}
+
+void RenderTarget::Bind()
+{
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+void RenderTarget::Unbind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+}
@@ -0,0 +1,40 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include "imgui.h"
+
+// An offscreen framebuffer with a single RGBA color texture.
+// Requires a current GL context for everything except the constructor;
+// call Destroy() before the context goes away.
+class RenderTarget {
+public:
+    RenderTarget();
+    ~RenderTarget();
+
+    // (Re)creates the framebuffer. linear_filter selects how the texture is
+    // sampled when drawn at a different size.
+    bool Create(int width, int height, bool linear_filter);
+    void Destroy();
+
+    // Redirects rendering into the target and sets the viewport to cover it.
+    // Unbind() restores the framebuffer and viewport that were active before.
+    void Bind();
+    void Unbind();
+
+    bool IsValid() const { return framebuffer != 0; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+    unsigned int GetFramebuffer() const { return framebuffer; }
+    ImTextureID GetTextureID() const { return static_cast<ImTextureID>(texture); }
+
+private:
+    unsigned int framebuffer;
+    unsigned int texture;
+    int width;
+    int height;
+
+    int previousFramebuffer;
+    int previousViewport[4];
+};
+
+#endif // RENDER_TARGET_H
@@ -1,9 +1,27 @@
 #include "Sprite.h"
 #include <algorithm>
 
+// Car pattern: 21 columns x 11 rows (0 = empty, 1 = body color, 2 = black).
+static const int SPRITE_WIDTH = 21;
+static const int SPRITE_HEIGHT = 11;
+static const unsigned char sprite_pattern[SPRITE_HEIGHT][SPRITE_WIDTH] = {
+    {0,0,2,2,2,2,2,2,2,2,2,2,0,0,0,0,0,0,0,0,0},
+    {0,2,1,1,1,1,1,1,1,1,1,1,2,0,0,0,0,0,0,0,0},
+    {2,2,1,2,2,2,2,2,1,1,2,2,1,2,0,0,0,0,0,0,0},
+    {2,1,2,2,2,2,2,2,1,1,2,2,2,1,2,2,2,2,2,0,0},
+    {2,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,2,2},
+    {2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,1,2},
+    {2,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,2},
+    {2,1,1,1,2,2,2,1,1,1,1,1,1,1,1,1,2,2,2,1,2},
+    {2,2,2,2,2,1,2,2,2,2,2,2,2,2,2,2,2,1,2,2,0},
+    {0,0,0,0,2,2,2,0,0,0,0,0,0,0,0,0,2,2,2,0,0},
+    {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+};
+
 Sprite::Sprite()
     : position(ImVec2(0.0f, 0.0f)),
-      size(ImVec2(24.0f, 24.0f))
+      size(ImVec2(24.0f, 24.0f)),
+      carFrame(-1)
 {
 }
 
@@ -14,6 +32,18 @@ void Sprite::Initialize(float scale)
     // Set sprite size to about 2×2 virtual units.
     // Note: Virtual coordinate system is now 80×25.
     size = ImVec2(2.0f * scale, 2.0f * scale);
+
+    // The atlas does not depend on the scale, so it is only built once.
+    // If it cannot be built, Draw() falls back to one rectangle per cell.
+    if (carFrame < 0) {
+        carFrame = atlas.AddFrame(&sprite_pattern[0][0], SPRITE_WIDTH, SPRITE_HEIGHT);
+        atlas.Build();
+    }
+}
+
+void Sprite::Cleanup()
+{
+    atlas.Cleanup();
 }
 
 void Sprite::UpdatePosition(float progress_fraction,
@@ -37,26 +67,18 @@ void Sprite::UpdatePosition(float progress_fraction,
 
 void Sprite::Draw(ImDrawList* draw_list, ImU32 color)
 {
-    // Updated sprite pattern: 21 columns x 11 rows.
-    const int SPRITE_WIDTH = 21;
-    const int SPRITE_HEIGHT = 11;
-    const int sprite_pattern[SPRITE_HEIGHT][SPRITE_WIDTH] = {
-        {0,0,2,2,2,2,2,2,2,2,2,2,0,0,0,0,0,0,0,0,0},
-        {0,2,1,1,1,1,1,1,1,1,1,1,2,0,0,0,0,0,0,0,0},
-        {2,2,1,2,2,2,2,2,1,1,2,2,1,2,0,0,0,0,0,0,0},
-        {2,1,2,2,2,2,2,2,1,1,2,2,2,1,2,2,2,2,2,0,0},
-        {2,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,2,2},
-        {2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,1,2},
-        {2,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,2},
-        {2,1,1,1,2,2,2,1,1,1,1,1,1,1,1,1,2,2,2,1,2},
-        {2,2,2,2,2,1,2,2,2,2,2,2,2,2,2,2,2,1,2,2,0},
-        {0,0,0,0,2,2,2,0,0,0,0,0,0,0,0,0,2,2,2,0,0},
-        {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},
-    };
-
     float pixel_size = 0.08f * size.x;
-    const ImU32 black_color = IM_COL32(0, 0, 0, 255);
 
+    // One textured quad; the atlas holds one texel per pattern cell.
+    if (atlas.IsBuilt()) {
+        const SpriteAtlas::Frame& frame = atlas.GetFrame(carFrame);
+        ImVec2 bot_right = ImVec2(position.x + frame.width * pixel_size,
+                                  position.y + frame.height * pixel_size);
+        draw_list->AddImage(atlas.GetTextureID(), position, bot_right, frame.uv0, frame.uv1, color);
+        return;
+    }
+
+    const ImU32 black_color = IM_COL32(0, 0, 0, 255);
     for (int y = 0; y < SPRITE_HEIGHT; ++y) {
         for (int x = 0; x < SPRITE_WIDTH; ++x) {
             int pixel = sprite_pattern[y][x];
@@ -70,7 +92,7 @@ void Sprite::Draw(ImDrawList* draw_list, ImU32 color)
             if (pixel == 1)
                 draw_list->AddRectFilled(top_left, bot_right, color);
             else if (pixel == 2)
-                draw_list->AddRectFilled(top_left, bot_right, IM_COL32(0, 0, 0, 255));
+                draw_list->AddRectFilled(top_left, bot_right, black_color);
         }
     }
 }
@@ -2,6 +2,7 @@
 #define SPRITE_H
 
 #include "imgui.h"
+#include "SpriteAtlas.h"
 
 class Sprite {
 public:
@@ -9,7 +10,10 @@ public:
     ~Sprite();
 
     // Initialize the sprite using a unified scale factor based on a virtual coordinate system of 80×25.
+    // Also bakes the sprite into its texture atlas (needs a current GL context).
     void Initialize(float scale);
+    // Frees the atlas texture; call before the GL context is destroyed.
+    void Cleanup();
     // UpdatePosition computes the sprite's position (using virtual coordinates)
     // based on progress along a line.
     void UpdatePosition(float progress_fraction,
@@ -25,6 +29,9 @@ public:
 private:
     ImVec2 position;
     ImVec2 size;
+
+    SpriteAtlas atlas;
+    int carFrame;
 };
 
 #endif // SPRITE_H
@@ -0,0 +1,96 @@
+#include "SpriteAtlas.h"
+#include <algorithm>
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+// Transparent texels between frames, so a frame never samples its neighbour.
+static const int FRAME_GUTTER = 1;
+
+SpriteAtlas::SpriteAtlas()
+    : texture(0)
+{
+}
+
+SpriteAtlas::~SpriteAtlas()
+{
+    // GL resources are released by Cleanup(); the context may be gone here.
+}
+
+int SpriteAtlas::AddFrame(const unsigned char* cells, int width, int height)
+{
+    Frame frame;
+    frame.width = width;
+    frame.height = height;
+    frame.uv0 = ImVec2(0.0f, 0.0f);
+    frame.uv1 = ImVec2(0.0f, 0.0f);
+    frames.push_back(frame);
+    patterns.emplace_back(cells, cells + width * height);
+    return static_cast<int>(frames.size()) - 1;
+}
+
+bool SpriteAtlas::Build()
+{
+    Cleanup();
+    if (frames.empty())
+        return false;
+
+    // A single shelf is plenty for a handful of small frames.
+    int atlas_width = FRAME_GUTTER;
+    int atlas_height = 0;
+    for (const Frame& frame : frames) {
+        atlas_width += frame.width + FRAME_GUTTER;
+        atlas_height = std::max(atlas_height, frame.height);
+    }
+    atlas_height += 2 * FRAME_GUTTER;
+
+    std::vector<unsigned int> pixels(atlas_width * atlas_height, IM_COL32(0, 0, 0, 0));
+    int x = FRAME_GUTTER;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        Frame& frame = frames[i];
+        const std::vector<unsigned char>& cells = patterns[i];
+        for (int cy = 0; cy < frame.height; ++cy) {
+            for (int cx = 0; cx < frame.width; ++cx) {
+                unsigned char cell = cells[cy * frame.width + cx];
+                ImU32 color = IM_COL32(0, 0, 0, 0);
+                if (cell == 1)
+                    color = IM_COL32(255, 255, 255, 255);
+                else if (cell == 2)
+                    color = IM_COL32(0, 0, 0, 255);
+                pixels[(FRAME_GUTTER + cy) * atlas_width + x + cx] = color;
+            }
+        }
+        frame.uv0 = ImVec2(static_cast<float>(x) / atlas_width,
+                           static_cast<float>(FRAME_GUTTER) / atlas_height);
+        frame.uv1 = ImVec2(static_cast<float>(x + frame.width) / atlas_width,
+                           static_cast<float>(FRAME_GUTTER + frame.height) / atlas_height);
+        x += frame.width + FRAME_GUTTER;
+    }
+
+    GLint lastTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // IM_COL32 is RGBA in memory order on little-endian, like the font atlas.
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlas_width, atlas_height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, lastTexture);
+    return true;
+}
+
+void SpriteAtlas::Cleanup()
+{
+    if (texture) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+}
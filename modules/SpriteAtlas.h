@@ -0,0 +1,44 @@
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#include "imgui.h"
+#include <vector>
+
+// Pixel-art frames packed side by side into one GL texture, one texel per
+// pattern cell. The texture is sampled with nearest filtering, so a frame
+// drawn as a single quad of any size covers exactly the pixels the old
+// one-rectangle-per-cell drawing did.
+//
+// Pattern cells: 0 = transparent, 1 = white (takes the tint color),
+// 2 = opaque black.
+class SpriteAtlas {
+public:
+    struct Frame {
+        int width;      // In cells.
+        int height;
+        ImVec2 uv0;
+        ImVec2 uv1;
+    };
+
+    SpriteAtlas();
+    ~SpriteAtlas();
+
+    // Queues a frame for the next Build(); returns its index.
+    int AddFrame(const unsigned char* cells, int width, int height);
+    // Packs all frames and uploads the texture. Requires a current GL context.
+    bool Build();
+    // Frees the texture; must be called while the GL context is current.
+    void Cleanup();
+
+    bool IsBuilt() const { return texture != 0; }
+    int GetFrameCount() const { return static_cast<int>(frames.size()); }
+    const Frame& GetFrame(int index) const { return frames[index]; }
+    ImTextureID GetTextureID() const { return static_cast<ImTextureID>(texture); }
+
+private:
+    std::vector<Frame> frames;
+    std::vector<std::vector<unsigned char>> patterns;
+    unsigned int texture;
+};
+
+#endif // SPRITE_ATLAS_H
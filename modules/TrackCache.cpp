@@ -0,0 +1,175 @@
+#include "TrackCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+
+TrackCache::TrackCache(size_t budgetBytes)
+    : budget(budgetBytes),
+      bytes(0),
+      hits(0),
+      misses(0),
+      evictions(0)
+{
+}
+
+void TrackCache::SetBudget(size_t bytesBudget)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytesBudget;
+    evict();
+}
+
+size_t TrackCache::GetBudget() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+TrackCache::Buffer TrackCache::Load(const std::string& path, const std::atomic<bool>* cancel)
+{
+    size_t limit = SIZE_MAX;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (budget > 0) {
+            limit = budget;
+            auto it = lookup.find(path);
+            if (it != lookup.end()) {
+                entries.splice(entries.begin(), entries, it->second);
+                hits++;
+                return it->second->data;
+            }
+            misses++;
+        }
+    }
+    // Read without holding the lock; the drive can take a while.
+    Buffer data = readFile(path, cancel, limit);
+    if (data)
+        insert(path, data);
+    return data;
+}
+
+TrackCache::Buffer TrackCache::Find(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = lookup.find(path);
+    if (it == lookup.end())
+        return nullptr;
+    entries.splice(entries.begin(), entries, it->second);
+    hits++;
+    return it->second->data;
+}
+
+unsigned long long TrackCache::GetHits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+unsigned long long TrackCache::GetMisses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+unsigned long long TrackCache::GetEvictions() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return evictions;
+}
+
+size_t TrackCache::GetBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+void TrackCache::PrintStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    unsigned long long lookups = hits + misses;
+    double percent = (lookups > 0) ? (100.0 * hits / lookups) : 0.0;
+    printf("Track cache: %llu hit(s), %llu miss(es) (%.1f%% hits), %llu eviction(s), %zu of %zu KB used by %zu track(s).\n",
+           hits, misses, percent, evictions, bytes / 1024, budget / 1024, entries.size());
+}
+
+size_t TrackCache::DefaultBudget()
+{
+    const char* megabytes = getenv("RADI0_TRACK_CACHE_MB");
+    if (!megabytes)
+        return 0;
+    long value = atol(megabytes);
+    return (value > 0) ? static_cast<size_t>(value) * 1024 * 1024 : 0;
+}
+
+// Reads the whole file, or gives up (nullptr) once it is over limit bytes.
+TrackCache::Buffer TrackCache::readFile(const std::string& path, const std::atomic<bool>* cancel, size_t limit)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return nullptr;
+    auto data = std::make_shared<std::vector<unsigned char>>();
+    // With a known size the buffer is allocated once and read into exactly;
+    // otherwise it grows a chunk at a time until end of file.
+    struct stat info;
+    bool sized = fstat(fileno(file), &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0;
+    if (sized) {
+        if (static_cast<unsigned long long>(info.st_size) > limit) {
+            fclose(file);
+            return nullptr;
+        }
+        data->resize(static_cast<size_t>(info.st_size));
+    }
+    // Read in chunks so a cancelled load stops early.
+    const size_t chunkSize = 256 * 1024;
+    size_t used = 0;
+    bool tooLarge = false;
+    while (!(cancel && cancel->load(std::memory_order_relaxed))) {
+        if (used == data->size()) {
+            if (sized)
+                break;
+            if (used >= limit) {
+                tooLarge = fgetc(file) != EOF;
+                break;
+            }
+            data->resize(std::min(used + chunkSize, limit));
+        }
+        size_t want = std::min(chunkSize, data->size() - used);
+        size_t got = fread(data->data() + used, 1, want, file);
+        used += got;
+        if (got < want)
+            break;
+    }
+    data->resize(used);
+    bool failed = ferror(file) != 0;
+    fclose(file);
+    if (failed || tooLarge || data->empty() || (cancel && cancel->load(std::memory_order_relaxed)))
+        return nullptr;
+    return data;
+}
+
+void TrackCache::insert(const std::string& path, const Buffer& data)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // A file larger than the whole budget would only flush everything else.
+    if (data->size() > budget || lookup.count(path))
+        return;
+    entries.push_front(Entry{ path, data });
+    lookup[path] = entries.begin();
+    bytes += data->size();
+    evict();
+}
+
+// Drops least recently used files until the cache fits its budget.
+// Called with the mutex held.
+void TrackCache::evict()
+{
+    while (bytes > budget && !entries.empty()) {
+        const Entry& last = entries.back();
+        bytes -= last.data->size();
+        lookup.erase(last.path);
+        entries.pop_back();
+        evictions++;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef TRACK_CACHE_H
+#define TRACK_CACHE_H
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Whole compressed track files kept in RAM, so playback reads from memory
+// (SDL_RWFromConstMem) instead of a USB stick that may stall mid-track.
+//
+// Least recently used files are evicted once the byte budget is exceeded.
+// Buffers are shared: a track that is playing keeps its buffer alive even
+// after it has been evicted. A file larger than the whole budget is never
+// read, so it cannot be held in RAM outside the budget; callers stream it.
+// A budget of 0 disables caching; Load() then just reads the file. Safe to
+// use from several threads.
+class TrackCache {
+public:
+    using Buffer = std::shared_ptr<const std::vector<unsigned char>>;
+
+    explicit TrackCache(size_t budgetBytes = 0);
+
+    void SetBudget(size_t bytes);
+    size_t GetBudget() const;
+    bool IsEnabled() const { return GetBudget() > 0; }
+
+    // Returns the file's contents, from the cache or read from disk (and
+    // then cached). Returns nullptr if the file cannot be read, is larger
+    // than the budget, or *cancel became true while reading.
+    Buffer Load(const std::string& path, const std::atomic<bool>* cancel = nullptr);
+
+    // The file's contents if they are cached, or nullptr; never touches the
+    // drive, so it is safe on the UI thread. Only hits are counted here:
+    // the Load() that fills the cache afterwards counts the miss.
+    Buffer Find(const std::string& path);
+
+    unsigned long long GetHits() const;
+    unsigned long long GetMisses() const;
+    unsigned long long GetEvictions() const;
+    size_t GetBytes() const;
+    void PrintStats() const;
+
+    // $RADI0_TRACK_CACHE_MB in megabytes, or 0 (disabled).
+    static size_t DefaultBudget();
+
+private:
+    struct Entry {
+        std::string path;
+        Buffer data;
+    };
+
+    static Buffer readFile(const std::string& path, const std::atomic<bool>* cancel, size_t limit);
+    void insert(const std::string& path, const Buffer& data);
+    void evict();
+
+    mutable std::mutex mutex;
+    size_t budget;
+    size_t bytes;
+    std::list<Entry> entries;   // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> lookup;
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+};
+
+#endif // TRACK_CACHE_H
@@ -0,0 +1,21 @@
+#ifndef TRACK_INFO_H
+#define TRACK_INFO_H
+
+#include <string>
+
+// Structure to hold track metadata.
+struct TrackInfo {
+    std::string filePath;
+    std::string artist;
+    std::string title;
+    float duration;       // in seconds
+    long long mtime;      // File modification time (ns), for the library index
+    long long size;       // File size in bytes, for the library index
+    float loudness;       // Integrated loudness (LUFS); 0 until analysed
+};
+
+// TrackInfo::loudness of a track that could not be measured (too long to
+// decode in memory, or not decodable). Real loudness is never positive.
+static const float LOUDNESS_UNMEASURABLE = 1000.0f;
+
+#endif // TRACK_INFO_H
@@ -0,0 +1,181 @@
+#include "TrackStore.h"
+#include <cstring>
+
+static const size_t BLOCK_SIZE = 64 * 1024;
+static const size_t LENGTH_BYTES = 2;
+static const size_t MAX_STRING = BLOCK_SIZE - LENGTH_BYTES;
+
+// Splits "dir/name" after the last '/', which stays with the directory.
+static void splitPath(std::string_view path, std::string_view& directory, std::string_view& name)
+{
+    size_t slash = path.find_last_of('/');
+    size_t split = (slash == std::string_view::npos) ? 0 : slash + 1;
+    directory = path.substr(0, split);
+    name = path.substr(split);
+}
+
+TrackStore::TrackStore()
+    : blockUsed(0)
+{
+}
+
+uint32_t TrackStore::Add(const TrackInfo& info)
+{
+    return Add(info.filePath, info.artist, info.title, info.duration, info.loudness, info.mtime, info.size);
+}
+
+uint32_t TrackStore::Add(std::string_view path, std::string_view artist, std::string_view title,
+                         float duration, float loudness, long long mtime, long long size)
+{
+    std::string_view directory;
+    std::string_view name;
+    splitPath(path, directory, name);
+    Track track;
+    track.directory = intern(directory);
+    track.name = store(name);
+    track.artist = intern(artist);
+    track.title = store(title);
+    track.duration = duration;
+    track.loudness = loudness;
+    tracks.push_back(track);
+    cold.push_back(Cold{ mtime, size });
+    return static_cast<uint32_t>(tracks.size() - 1);
+}
+
+void TrackStore::Reserve(size_t count)
+{
+    tracks.reserve(count);
+    cold.reserve(count);
+}
+
+void TrackStore::Clear()
+{
+    tracks.clear();
+    cold.clear();
+    interned.clear();
+    blocks.clear();
+    blockUsed = 0;
+}
+
+std::string TrackStore::GetPath(uint32_t index) const
+{
+    std::string_view directory = getString(tracks[index].directory);
+    std::string_view name = getString(tracks[index].name);
+    std::string path;
+    path.reserve(directory.size() + name.size());
+    path.append(directory);
+    path.append(name);
+    return path;
+}
+
+TrackInfo TrackStore::GetInfo(uint32_t index) const
+{
+    const Track& track = tracks[index];
+    TrackInfo info;
+    info.filePath = GetPath(index);
+    info.artist = std::string(getString(track.artist));
+    info.title = std::string(getString(track.title));
+    info.duration = track.duration;
+    info.loudness = track.loudness;
+    info.mtime = cold[index].mtime;
+    info.size = cold[index].size;
+    return info;
+}
+
+bool TrackStore::Find(std::string_view path, uint32_t& index) const
+{
+    std::string_view directory;
+    std::string_view name;
+    splitPath(path, directory, name);
+    auto it = interned.find(directory);
+    if (it == interned.end())
+        return false;
+    for (size_t i = 0; i < tracks.size(); i++) {
+        if (tracks[i].directory == it->second && getString(tracks[i].name) == name) {
+            index = static_cast<uint32_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TrackStore::UpdateLoudness(const std::vector<std::pair<std::string, float>>& measured)
+{
+    // Directory id -> (name, loudness) of the tracks measured in it.
+    std::unordered_map<uint32_t, std::vector<std::pair<std::string_view, float>>> byDirectory;
+    for (const auto& entry : measured) {
+        std::string_view directory;
+        std::string_view name;
+        splitPath(entry.first, directory, name);
+        auto it = interned.find(directory);
+        if (it != interned.end())
+            byDirectory[it->second].emplace_back(name, entry.second);
+    }
+    if (byDirectory.empty())
+        return;
+    for (Track& track : tracks) {
+        auto it = byDirectory.find(track.directory);
+        if (it == byDirectory.end())
+            continue;
+        for (const auto& entry : it->second) {
+            if (getString(track.name) == entry.first) {
+                track.loudness = entry.second;
+                break;
+            }
+        }
+    }
+}
+
+size_t TrackStore::GetMemoryUsage() const
+{
+    // Per interned string: a hash node (next pointer, key, value, cached
+    // hash) and its bucket.
+    size_t nodeBytes = sizeof(void*) + sizeof(std::string_view) + sizeof(uint32_t) + sizeof(size_t);
+    return tracks.capacity() * sizeof(Track) +
+           cold.capacity() * sizeof(Cold) +
+           blocks.size() * BLOCK_SIZE +
+           blocks.capacity() * sizeof(std::unique_ptr<unsigned char[]>) +
+           interned.size() * nodeBytes +
+           interned.bucket_count() * sizeof(void*);
+}
+
+// -----------------------------------------------------------------------------
+// Private Helper Functions
+// -----------------------------------------------------------------------------
+
+// Copies 'text' into the arena and returns its id.
+uint32_t TrackStore::store(std::string_view text)
+{
+    if (text.size() > MAX_STRING)
+        text = text.substr(0, MAX_STRING);
+    if (blocks.empty() || blockUsed + LENGTH_BYTES + text.size() > BLOCK_SIZE) {
+        blocks.emplace_back(new unsigned char[BLOCK_SIZE]);
+        blockUsed = 0;
+    }
+    unsigned char* slot = blocks.back().get() + blockUsed;
+    slot[0] = static_cast<unsigned char>(text.size() & 0xFF);
+    slot[1] = static_cast<unsigned char>(text.size() >> 8);
+    if (!text.empty())
+        std::memcpy(slot + LENGTH_BYTES, text.data(), text.size());
+    uint32_t id = static_cast<uint32_t>((blocks.size() - 1) * BLOCK_SIZE + blockUsed);
+    blockUsed += LENGTH_BYTES + text.size();
+    return id;
+}
+
+std::string_view TrackStore::getString(uint32_t id) const
+{
+    const unsigned char* slot = blocks[id / BLOCK_SIZE].get() + id % BLOCK_SIZE;
+    size_t length = slot[0] | (static_cast<size_t>(slot[1]) << 8);
+    return std::string_view(reinterpret_cast<const char*>(slot + LENGTH_BYTES), length);
+}
+
+// Like store(), but returns the existing id for a string already interned.
+uint32_t TrackStore::intern(std::string_view text)
+{
+    auto it = interned.find(text);
+    if (it != interned.end())
+        return it->second;
+    uint32_t id = store(text);
+    interned.emplace(getString(id), id);
+    return id;
+}
@@ -0,0 +1,81 @@
+#ifndef TRACK_STORE_H
+#define TRACK_STORE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "TrackInfo.h"
+
+// The USB playlist's tracks, kept compact for libraries of 100k+ files.
+//
+// Strings live in an arena of 64 KB blocks, each behind a 16-bit length,
+// and are referred to by their position in it. Directories and artists are
+// interned, so a folder's path and an artist's name are stored once
+// however many tracks share them; file names and titles are nearly always
+// unique and are stored as they come. Strings are cut at 64 KB - 2 bytes.
+// What the playlist walks is a fixed-size Track record; the mtime and
+// size, only needed to rebuild a TrackInfo, are kept apart.
+//
+// Not thread-safe; the USB manager only touches it from one thread at a time.
+class TrackStore {
+public:
+    struct Track {
+        uint32_t directory;   // Interned, with its trailing '/'
+        uint32_t name;        // File name within the directory
+        uint32_t artist;      // Interned
+        uint32_t title;
+        float duration;       // Seconds
+        float loudness;       // LUFS, 0 if not analysed yet (see LOUDNESS_UNMEASURABLE)
+    };
+
+    TrackStore();
+
+    // Returns the new track's index.
+    uint32_t Add(const TrackInfo& info);
+    uint32_t Add(std::string_view path, std::string_view artist, std::string_view title,
+                 float duration, float loudness, long long mtime, long long size);
+    void Reserve(size_t count);
+    void Clear();
+
+    size_t GetCount() const { return tracks.size(); }
+    const Track& Get(uint32_t index) const { return tracks[index]; }
+    std::string_view GetArtist(uint32_t index) const { return getString(tracks[index].artist); }
+    std::string_view GetTitle(uint32_t index) const { return getString(tracks[index].title); }
+    std::string GetPath(uint32_t index) const;
+    TrackInfo GetInfo(uint32_t index) const;
+
+    // Looks up a full path: one hash lookup for its directory, then a scan
+    // over all tracks comparing the directory id before the name.
+    bool Find(std::string_view path, uint32_t& index) const;
+    // Stores measured loudness by path in one pass over the tracks.
+    // Paths that are not in the store are ignored.
+    void UpdateLoudness(const std::vector<std::pair<std::string, float>>& measured);
+
+    // Bytes held by the records, the arena and the lookup tables.
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Cold {
+        long long mtime;
+        long long size;
+    };
+
+    uint32_t store(std::string_view text);
+    uint32_t intern(std::string_view text);
+    std::string_view getString(uint32_t id) const;
+
+    std::vector<Track> tracks;
+    std::vector<Cold> cold;
+
+    // A string's id is its block's index times the block size plus its
+    // offset in the block.
+    std::vector<std::unique_ptr<unsigned char[]>> blocks;
+    size_t blockUsed;      // Bytes used in blocks.back()
+    std::unordered_map<std::string_view, uint32_t> interned;   // Views into the arena
+};
+
+#endif // TRACK_STORE_H
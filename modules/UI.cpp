@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <string>
 #include <cmath>
+#include <cstring>
 
 // Define some colors (using the new hex #6dfe95)
 const ImU32 COLOR_GREEN = IM_COL32(109, 254, 149, 255);
@@ -11,7 +12,7 @@ const ImU32 COLOR_BLACK = IM_COL32(0, 0, 0, 255);
 // A constant for PI.
 static const float PI = 3.1415926f;
 
-UI::UI() {}
+UI::UI() : animating(false), staticLayersBuilt(false) {}
 UI::~UI() {}
 
 void UI::Initialize()
@@ -19,104 +20,85 @@ void UI::Initialize()
     // No special initialization needed.
 }
 
-void UI::Render(ImDrawList* draw_list,
-                IAudioManager& audioManager,
+void UI::Render(Compositor& compositor,
+                const PlaybackSnapshot& playback,
                 Sprite& sprite,
+                float delta_time,
                 float scale,
                 float offset_x,
                 float offset_y,
                 int window_width,
                 int window_height)
 {
+    UpdateStaticLayers(scale, offset_x, offset_y, window_width, window_height);
+
     // 1) Draw the volume indicator (sun/moon) behind the progress line.
-    DrawVolumeSun(draw_list, audioManager, scale, offset_x, offset_y);
-    
-    // 2) Draw the progress line.
-    DrawProgressLine(draw_list, audioManager, scale, offset_x, offset_y);
+    DrawVolumeSun(compositor.Layer(DrawLayer::Background), playback, scale, offset_x, offset_y);
     
-    // 3) Draw the car sprite and its mask bars.
+    // 2) Sun mask and progress line (cached) hide the part of the sun that
+    //    is below the horizon.
+    DrawHorizonLayer(compositor.Layer(DrawLayer::Horizon), scale, offset_x, offset_y);
+
+    // 3) Draw the car sprite on the progress line.
     constexpr float spriteVirtualWidth = 19 * 0.16f; // ~3.04 virtual units.
     float effectiveStartX = layout.progressBarStartX - spriteVirtualWidth + layout.spriteXCorrection;
     float effectiveEndX   = layout.progressBarEndX + layout.spriteXCorrection;
-    sprite.UpdatePosition(audioManager.GetPlaybackFraction(),
+    sprite.UpdatePosition(playback.fraction,
                           effectiveStartX, effectiveEndX,
                           scale, offset_x, offset_y,
                           layout.spriteXOffset,
                           layout.spriteYOffset,
                           layout.spriteBaseY);
-    sprite.Draw(draw_list, COLOR_GREEN);
-    DrawMaskBars(draw_list, scale, offset_x, offset_y);
-    
+    sprite.Draw(compositor.Layer(DrawLayer::Sprite), COLOR_GREEN);
+
     // 4) Draw the artist and track info on top.
-    DrawArtistAndTrackInfo(draw_list, audioManager, scale, offset_x, offset_y);
-    
-    // Note: Borders are now drawn separately via DrawBorders() in the overlay.
+    DrawArtistAndTrackInfo(compositor.Layer(DrawLayer::Text), playback, delta_time, scale, offset_x, offset_y);
+
+    // 5) Mask bars and borders (cached) go above the exhaust layer, so the
+    //    bars hide the sun, sprite and exhaust outside the track.
+    DrawFrameLayer(compositor.Layer(DrawLayer::Frame), scale, offset_x, offset_y, window_width, window_height);
 }
 
 void UI::Cleanup()
 {
-    // No cleanup needed.
+    layerCache.Cleanup();
+    staticLayersBuilt = false;
 }
 
 void UI::DrawArtistAndTrackInfo(ImDrawList* draw_list,
-                                IAudioManager& audioManager,
+                                const PlaybackSnapshot& playback,
+                                float delta_time,
                                 float scale,
                                 float offset_x,
                                 float offset_y)
 {
-    std::string artist_name = audioManager.GetCurrentTrackArtist();
-    std::string track_name  = audioManager.GetCurrentTrackTitle();
-    if (artist_name.empty()) artist_name = "Unknown Artist";
-    if (track_name.empty()) track_name  = "Unknown Track";
-    
+    // Point at the snapshot's strings instead of copying them every frame.
+    const char* artist_name = playback.artist.empty() ? "Unknown Artist" : playback.artist.c_str();
+    const char* track_name  = playback.title.empty() ? "Unknown Track" : playback.title.c_str();
+
+    // Both texts are laid out once per change; scrolling only moves them.
+    float font_size = ImGui::GetFontSize() * TEXT_FONT_SCALE;
+    artistMarquee.SetText(artist_name, font_size);
+    trackMarquee.SetText(track_name, font_size);
+    float dt = delta_time * 30.0f;
+
     // Artist text region.
     ImVec2 artistPos = ToPixels(layout.artistTextX, layout.artistTextY, scale, offset_x, offset_y);
     float artistRegionWidth_px = layout.artistTextWidth * scale;
-    ImGui::SetWindowFontScale(1.6f);
-    ImVec2 artistTextSize = ImGui::CalcTextSize(artist_name.c_str());
-    static float artist_scroll_offset = 0.0f;
-    float dt = ImGui::GetIO().DeltaTime * 30.0f;
-    if (artistTextSize.x > artistRegionWidth_px) {
-        artist_scroll_offset += dt;
-        if (artist_scroll_offset > artistTextSize.x)
-            artist_scroll_offset = -artistRegionWidth_px;
-    } else {
-        artist_scroll_offset = 0.0f;
-    }
-    ImVec2 artistClipMin = artistPos;
-    ImVec2 artistClipMax = ImVec2(artistPos.x + artistRegionWidth_px, artistPos.y + artistTextSize.y);
-    draw_list->PushClipRect(artistClipMin, artistClipMax, true);
-    ImGui::SetCursorPos(ImVec2(artistPos.x - artist_scroll_offset, artistPos.y));
-    ImGui::TextUnformatted(artist_name.c_str());
-    draw_list->PopClipRect();
-    ImGui::SetWindowFontScale(1.0f);
-    
-    // Track text region (right-aligned).
+    artistMarquee.Scroll(dt, artistRegionWidth_px);
+    artistMarquee.Draw(draw_list, artistPos, artistRegionWidth_px, false);
+
+    // Track text region (an overflowing title starts with its end visible).
     ImVec2 trackPos = ToPixels(layout.trackTextX, layout.trackTextY, scale, offset_x, offset_y);
     float trackRegionWidth_px = layout.trackTextWidth * scale;
-    ImGui::SetWindowFontScale(1.6f);
-    ImVec2 trackTextSize = ImGui::CalcTextSize(track_name.c_str());
-    static float track_scroll_offset = 0.0f;
-    if (trackTextSize.x > trackRegionWidth_px) {
-        track_scroll_offset += dt;
-        if (track_scroll_offset > trackTextSize.x)
-            track_scroll_offset = -trackRegionWidth_px;
-    } else {
-        track_scroll_offset = 0.0f;
-    }
-    ImVec2 trackClipMin = trackPos;
-    ImVec2 trackClipMax = ImVec2(trackPos.x + trackRegionWidth_px, trackPos.y + trackTextSize.y);
-    draw_list->PushClipRect(trackClipMin, trackClipMax, true);
-    float textOffset = trackTextSize.x - trackRegionWidth_px;
-    if (textOffset < 0) textOffset = 0;
-    ImGui::SetCursorPos(ImVec2(trackPos.x - track_scroll_offset - textOffset, trackPos.y));
-    ImGui::TextUnformatted(track_name.c_str());
-    draw_list->PopClipRect();
-    ImGui::SetWindowFontScale(1.0f);
+    trackMarquee.Scroll(dt, trackRegionWidth_px);
+    trackMarquee.Draw(draw_list, trackPos, trackRegionWidth_px, true);
+
+    animating = artistMarquee.IsScrolling(artistRegionWidth_px) ||
+                trackMarquee.IsScrolling(trackRegionWidth_px);
 }
 
 void UI::DrawProgressLine(ImDrawList* draw_list,
-                          IAudioManager& /*audioManager*/,
                           float scale,
                           float offset_x,
                           float offset_y)
@@ -147,7 +129,7 @@ void UI::DrawMaskBars(ImDrawList* draw_list,
 }
 
 void UI::DrawVolumeSun(ImDrawList* draw_list,
-                       IAudioManager& audioManager,
+                       const PlaybackSnapshot& playback,
                        float scale,
                        float offset_x,
                        float offset_y)
@@ -155,7 +137,7 @@ void UI::DrawVolumeSun(ImDrawList* draw_list,
     float C_x = layout.indicatorCenterX;
     float C_y = layout.indicatorCenterY;
     float R   = layout.indicatorRadius;
-    float vol = static_cast<float>(audioManager.GetVolume());
+    float vol = static_cast<float>(playback.volume);
     float x, y;
     
     if (vol >= 64.0f) {
@@ -212,7 +194,7 @@ void UI::DrawVolumeSun(ImDrawList* draw_list,
         draw_list->AddCircleFilled(cutoutCenter, moon_radius_px, COLOR_BLACK, 32);
     }
     
-    DrawSunMask(draw_list, scale, offset_x, offset_y);
+    // The sun mask is part of the cached horizon layer.
 }
 
 void UI::DrawSunMask(ImDrawList* draw_list,
@@ -251,3 +233,57 @@ void UI::DrawBorders(ImDrawList* draw_list, int window_width, int window_height)
     
     draw_list->AddRect(innerBorderTopLeft, innerBorderBottomRight, COLOR_GREEN, 0.0f, 0, 1.0f);
 }
+
+// Rebuilds the cached static layers if the layout or window geometry changed.
+void UI::UpdateStaticLayers(float scale,
+                            float offset_x,
+                            float offset_y,
+                            int window_width,
+                            int window_height)
+{
+    // LayoutConfig is plain floats, so a byte compare is enough.
+    if (staticLayersBuilt &&
+        std::memcmp(&staticLayerKey.layout, &layout, sizeof(layout)) == 0 &&
+        staticLayerKey.scale == scale &&
+        staticLayerKey.offset_x == offset_x &&
+        staticLayerKey.offset_y == offset_y &&
+        staticLayerKey.window_width == window_width &&
+        staticLayerKey.window_height == window_height)
+        return;
+
+    staticLayerKey.layout = layout;
+    staticLayerKey.scale = scale;
+    staticLayerKey.offset_x = offset_x;
+    staticLayerKey.offset_y = offset_y;
+    staticLayerKey.window_width = window_width;
+    staticLayerKey.window_height = window_height;
+    staticLayersBuilt = true;
+
+    // A layer that fails to cache is drawn directly (see Draw*Layer()).
+    ImDrawList* horizon = layerCache.BeginLayer(window_width, window_height);
+    DrawSunMask(horizon, scale, offset_x, offset_y);
+    DrawProgressLine(horizon, scale, offset_x, offset_y);
+    layerCache.EndLayer(StaticLayer::Horizon);
+
+    ImDrawList* frame = layerCache.BeginLayer(window_width, window_height);
+    DrawMaskBars(frame, scale, offset_x, offset_y);
+    DrawBorders(frame, window_width, window_height);
+    layerCache.EndLayer(StaticLayer::Frame);
+}
+
+void UI::DrawHorizonLayer(ImDrawList* draw_list, float scale, float offset_x, float offset_y)
+{
+    if (layerCache.Draw(draw_list, StaticLayer::Horizon))
+        return;
+    DrawSunMask(draw_list, scale, offset_x, offset_y);
+    DrawProgressLine(draw_list, scale, offset_x, offset_y);
+}
+
+void UI::DrawFrameLayer(ImDrawList* draw_list, float scale, float offset_x, float offset_y,
+                        int window_width, int window_height)
+{
+    if (layerCache.Draw(draw_list, StaticLayer::Frame))
+        return;
+    DrawMaskBars(draw_list, scale, offset_x, offset_y);
+    DrawBorders(draw_list, window_width, window_height);
+}
@@ -5,6 +5,9 @@
 #include "IAudioManager.h"   // Use the common interface
 #include "Sprite.h"
 #include "Utilities.h"
+#include "LayerCache.h"
+#include "Compositor.h"
+#include "MarqueeText.h"
 
 // Layout configuration structure (virtual coordinates in an 80×25 space)
 struct LayoutConfig {
@@ -63,9 +66,12 @@ public:
     ~UI();
 
     void Initialize();
-    void Render(ImDrawList* draw_list,
-                IAudioManager& audioManager,
+    // Records the HUD into the compositor's layers; the caller adds the
+    // exhaust layer and merges. delta_time (seconds) advances the marquee.
+    void Render(Compositor& compositor,
+                const PlaybackSnapshot& playback,
                 Sprite& sprite,
+                float delta_time,
                 float scale,
                 float offset_x,
                 float offset_y,
@@ -75,25 +81,29 @@ public:
 
     LayoutConfig& GetLayoutConfig() { return layout; }
 
+    // True if the last Render() drew something that moves on its own
+    // (currently the scrolling artist/track marquee).
+    bool IsAnimating() const { return animating; }
+
     // Public methods for drawing mask bars and borders.
     void DrawMaskBars(ImDrawList* draw_list, float scale, float offset_x, float offset_y);
     void DrawBorders(ImDrawList* draw_list, int window_width, int window_height);
 
 private:
     void DrawArtistAndTrackInfo(ImDrawList* draw_list,
-                                IAudioManager& audioManager,
+                                const PlaybackSnapshot& playback,
+                                float delta_time,
                                 float scale,
                                 float offset_x,
                                 float offset_y);
 
     void DrawProgressLine(ImDrawList* draw_list,
-                          IAudioManager& audioManager,
                           float scale,
                           float offset_x,
                           float offset_y);
 
     void DrawVolumeSun(ImDrawList* draw_list,
-                       IAudioManager& audioManager,
+                       const PlaybackSnapshot& playback,
                        float scale,
                        float offset_x,
                        float offset_y);
@@ -102,7 +112,35 @@ private:
                      float offset_x,
                      float offset_y);
 
+    // Static layers only depend on the layout and the window geometry.
+    void UpdateStaticLayers(float scale,
+                            float offset_x,
+                            float offset_y,
+                            int window_width,
+                            int window_height);
+    void DrawHorizonLayer(ImDrawList* draw_list, float scale, float offset_x, float offset_y);
+    void DrawFrameLayer(ImDrawList* draw_list, float scale, float offset_x, float offset_y,
+                        int window_width, int window_height);
+
+    // Inputs the cached static layers were built from.
+    struct StaticLayerKey {
+        LayoutConfig layout;
+        float scale;
+        float offset_x;
+        float offset_y;
+        int window_width;
+        int window_height;
+    };
+
     LayoutConfig layout;
+    bool animating;
+
+    MarqueeText artistMarquee;
+    MarqueeText trackMarquee;
+
+    LayerCache layerCache;
+    StaticLayerKey staticLayerKey;
+    bool staticLayersBuilt;
 };
 
 #endif // UI_H
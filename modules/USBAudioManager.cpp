@@ -1,13 +1,26 @@
 #include "USBAudioManager.h"
+#include "Id3Reader.h"
+#include "LibraryIndex.h"
+#include "LoudnessMeter.h"
+#include "Mp3Probe.h"
 #include <SDL.h>
 #include <SDL_mixer.h>
 #include <dirent.h>
+#include <strings.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <iterator>
 #include <random>
+#include <string_view>
 #include <vector>
 
 // Utility function to check if a directory exists
@@ -18,7 +31,7 @@ static bool directoryExists(const std::string &path) {
 
 // Function to get the USB mount path dynamically based on the current username.
 // It assumes that the USB is named "Mustick".
-static std::string getUSBMountPath() {
+std::string USBAudioManager::GetMountPath() {
     const char* username = getenv("USER");
     std::string user = (username) ? username : "default";
     return "/media/" + user + "/Mustick";
@@ -77,14 +90,139 @@ static void parseFilename(const std::string &filename, std::string &artist, std:
     }
 }
 
+static bool isMp3(const std::string &filename) {
+    return filename.size() > 4 && strcasecmp(filename.c_str() + filename.size() - 4, ".mp3") == 0;
+}
+
+// An event type of our own, so the wake-up cannot be mistaken for another
+// user event (MountWatcher registers its own). 0 if SDL has none left.
+static Uint32 wakeEventType() {
+    static const Uint32 type = [] {
+        Uint32 registered = SDL_RegisterEvents(1);
+        return registered == static_cast<Uint32>(-1) ? 0 : registered;
+    }();
+    return type;
+}
+
+// Called on SDL_mixer's audio thread when a track ends. Wakes the main loop
+// so Update() starts the next track right away instead of after the
+// scheduler's idle timeout.
+static void onMusicFinished() {
+    Uint32 type = wakeEventType();
+    if (type == 0)
+        return;
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = type;
+    SDL_PushEvent(&event);
+}
+
+// Mixer period in sample frames: $RADI0_AUDIO_PERIOD, rounded down to a
+// power of two between 256 (~6 ms) and 8192, or 4096 (~93 ms) by default.
+static int audioPeriodFrames() {
+    int frames = 4096;
+    if (const char* period = getenv("RADI0_AUDIO_PERIOD"))
+        frames = std::clamp(atoi(period), 256, 8192);
+    int power = 256;
+    while (power * 2 <= frames)
+        power *= 2;
+    return power;
+}
+
+// Output rate: $RADI0_AUDIO_RATE, else the default device's own rate so
+// neither SDL nor ALSA's plug layer resamples the mixed output, else 44100.
+// Tracks at another rate are still converted once, by SDL_mixer's decoder.
+static int audioOutputFrequency() {
+    if (const char* rate = getenv("RADI0_AUDIO_RATE"))
+        return std::clamp(atoi(rate), 8000, 192000);
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+    SDL_AudioSpec device;
+    if (SDL_GetDefaultAudioInfo(nullptr, &device, 0) == 0 && device.freq > 0)
+        return device.freq;
+#endif
+    return 44100;
+}
+
+// Index entries can be stale (deleted or renamed since the last scan);
+// Play() skips at most this many tracks that fail to open before giving up.
+static const size_t MAX_SKIPPED_TRACKS = 10;
+
+// Per-track gain brings every analysed track to this loudness (the
+// ReplayGain 2.0 reference level), within the limits below.
+static const float LOUDNESS_TARGET_LUFS = -18.0f;
+static const float MIN_TRACK_GAIN = 0.25f;
+static const float MAX_TRACK_GAIN = 4.0f;
+// Measured tracks are handed to the playlist in batches of this many.
+static const size_t LOUDNESS_BATCH = 25;
+// The index, a multi-MB file for a big library, is rewritten with the
+// results so far at most this often (and once at the end), to spare the
+// SD card.
+static const std::chrono::minutes LOUDNESS_CHECKPOINT(5);
+// A track is decoded whole into RAM to be measured; longer ones are
+// skipped. 96 MB is about 8.5 minutes of 48 kHz stereo.
+static const double LOUDNESS_MAX_DECODE_BYTES = 96.0 * 1024 * 1024;
+// Bit rate assumed when a track's duration is unknown.
+static const double LOUDNESS_ASSUMED_BITRATE = 128000.0;
+
+// RADI0_LOUDNESS=0 turns off both the analysis and the per-track gain.
+static bool loudnessEnabled() {
+    const char* setting = getenv("RADI0_LOUDNESS");
+    return !setting || strcmp(setting, "0") != 0;
+}
+
+// Nice 19 and the idle I/O class, for the calling thread only: the
+// analysis then only gets the CPU and the drive when playback, the
+// preload and the UI leave them unused.
+static void lowerThreadPriority() {
+    const int IOPRIO_WHO_PROCESS = 1;
+    const int IOPRIO_CLASS_IDLE = 3;
+    const int IOPRIO_CLASS_SHIFT = 13;
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 19);
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+}
+
+// Decodes a whole track with SDL_mixer, which hands it back in the output
+// format (16-bit, 'channels' at 'rate'), and measures it. The whole track
+// is held in RAM, hence the length cap in analyzeLoudness().
+static bool measureLoudness(const std::string& path, int rate, int channels, float& lufs, double& seconds) {
+    Mix_Chunk* chunk = Mix_LoadWAV_RW(SDL_RWFromFile(path.c_str(), "rb"), 1);
+    if (!chunk)
+        return false;
+    LoudnessMeter meter(rate, channels);
+    size_t frames = chunk->alen / (sizeof(Sint16) * channels);
+    meter.Process(reinterpret_cast<const short*>(chunk->abuf), frames);
+    Mix_FreeChunk(chunk);
+    seconds = static_cast<double>(frames) / rate;
+    return meter.GetIntegratedLoudness(lufs);
+}
+
 USBAudioManager::USBAudioManager()
-    : currentTrackIndex(0),
+    : libraryVersion(NextPlaybackVersion()),
+      currentTrackIndex(0),
       state(PlaybackState::Stopped),
       volume(64),
       baseVolume(64),      // User-set volume (0 to MIX_MAX_VOLUME)
       gainFactor(0.40f),    // Default gain factor (1.0 means no change)
-      playbackPosition(0.0f),
-      currentMusic(nullptr)
+      mixedBytes(0),
+      musicRunning(false),
+      outputBytesPerSecond(0.0),
+      initStage(UsbInitStage::WaitingForMount),
+      initVersion(NextPlaybackVersion()),
+      initCancel(false),
+      initialized(false),
+      playRequested(false),
+      metadataVersion(NextPlaybackVersion()),
+      currentMusic(nullptr),
+      trackCache(TrackCache::DefaultBudget()),
+      preloadCancel(false),
+      preloadDone(false),
+      preloadMusic(nullptr),
+      scanFinished(false),
+      loudnessDone(0),
+      loudnessTotal(0),
+      rescanReady(false),
+      rescanCancel(false)
 {
 }
 
@@ -93,55 +231,222 @@ USBAudioManager::~USBAudioManager() {
 }
 
 bool USBAudioManager::Initialize() {
-    if (!directoryExists(getUSBMountPath())) {
-        std::cerr << "USB drive not found at " << getUSBMountPath() << "\n";
+    stopInitialization();
+    stopRescan();
+    discardPreload();
+    std::string mountPath = GetMountPath();
+    if (!directoryExists(mountPath)) {
+        std::cerr << "USB drive not found at " << mountPath << "\n";
         return false;
     }
     // Clear any previous playlist
     playlist.clear();
+    library.Clear();
+    initialized = false;
+    playRequested = false;
+    initError.clear();
+    setInitStage(UsbInitStage::WaitingForMount);
+    initThread = std::thread(&USBAudioManager::initializeAsync, this, mountPath);
+    return true;
+}
 
-    // Wait a short time to allow the USB drive to settle
-    SDL_Delay(1000);  // 1 second delay
+UsbInitStage USBAudioManager::GetInitStage() const {
+    return initStage.load(std::memory_order_acquire);
+}
+
+// Runs on initThread: mount ready -> audio open -> library loaded -> first
+// track primed. Update() picks up the result.
+void USBAudioManager::initializeAsync(std::string mountPath) {
+    if (!waitForMount(mountPath)) {
+        failInitialization("USB drive not ready");
+        return;
+    }
+    setInitStage(UsbInitStage::OpeningAudio);
+    if (!openAudio()) {
+        failInitialization("Audio output unavailable");
+        return;
+    }
+    setInitStage(UsbInitStage::LoadingLibrary);
+    if (!loadLibrary(mountPath)) {
+        failInitialization("No music on USB drive");
+        return;
+    }
+    shufflePlaylist();
+    // Read and open the first track into the preload slot, where
+    // loadCurrentTrack() will take it from.
+    setInitStage(UsbInitStage::PrimingFirstTrack);
+    preloadPath = library.GetPath(playlist[currentTrackIndex]);
+    preloadTrack(preloadPath);
+    if (initCancel.load())
+        return;
+    setInitStage(UsbInitStage::Ready);
+    // Wake the main loop so it starts playing right away.
+    onMusicFinished();
+}
+
+// Replaces a fixed settle delay: polls until the path is an actual mount
+// (on a different device than its parent, not just the empty mount point)
+// and its root directory can be read.
+bool USBAudioManager::waitForMount(const std::string& mountPath) {
+    const int pollMs = 20;
+    const int timeoutMs = 10000;
+    std::string parent = mountPath.substr(0, mountPath.find_last_of('/'));
+    for (int waited = 0; waited <= timeoutMs && !initCancel.load(); waited += pollMs) {
+        struct stat mountInfo;
+        struct stat parentInfo;
+        if (stat(mountPath.c_str(), &mountInfo) == 0 && S_ISDIR(mountInfo.st_mode) &&
+            stat(parent.c_str(), &parentInfo) == 0 && mountInfo.st_dev != parentInfo.st_dev) {
+            if (DIR* dir = opendir(mountPath.c_str())) {
+                bool readable = readdir(dir) != nullptr;
+                closedir(dir);
+                if (readable) {
+                    if (waited > 0)
+                        printf("USB drive ready after %d ms.\n", waited);
+                    return true;
+                }
+            }
+        }
+        SDL_Delay(pollMs);
+    }
+    std::cerr << "USB drive at " << mountPath << " did not become ready.\n";
+    return false;
+}
 
+bool USBAudioManager::openAudio() {
     // (Reeeee)initialize the audio subsystem for this manager.
     if (SDL_Init(SDL_INIT_AUDIO) < 0) {
         std::cerr << "SDL audio initialization failed: " << SDL_GetError() << "\n";
         return false;
     }
     // Increased chunk size from 2048 to 4096 to help reduce crackling (testing fine so far)
-    const int audioFrequency = 44100;
+    // Quiet boards can run much smaller periods; see audioPeriodFrames().
+    const int audioFrequency = audioOutputFrequency();
     const int audioFormat = MIX_DEFAULT_FORMAT;
     const int audioChannels = 2;
-    const int audioChunkSize = 4096;
-    if (Mix_OpenAudio(audioFrequency, audioFormat, audioChannels, audioChunkSize) < 0) {
+    const int audioChunkSize = audioPeriodFrames();
+    // Let the device keep its own rate if it refuses ours; SDL_mixer then
+    // mixes at that rate instead of SDL converting behind it.
+    if (Mix_OpenAudioDevice(audioFrequency, audioFormat, audioChannels, audioChunkSize,
+                            nullptr, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE) < 0) {
         std::cerr << "SDL_mixer could not initialize! SDL_mixer Error: " << Mix_GetError() << "\n";
         return false;
     }
-    // Scan the USB directory for MP3 files
-    if (!scanUSBDirectory()) {
-        std::cerr << "No MP3 files found on USB drive.\n";
-        return false;
+    Mix_HookMusicFinished(onMusicFinished);
+    int mixFrequency = 0;
+    Uint16 mixFormat = 0;
+    int mixChannels = 0;
+    double bytesPerSecond = 0.0;
+    if (Mix_QuerySpec(&mixFrequency, &mixFormat, &mixChannels))
+        bytesPerSecond = static_cast<double>(mixFrequency) * mixChannels * (SDL_AUDIO_BITSIZE(mixFormat) / 8);
+    outputBytesPerSecond.store(bytesPerSecond);
+    printf("Audio output: %d Hz, period %d frames (%.1f ms).\n",
+           mixFrequency, audioChunkSize, 1000.0 * audioChunkSize / mixFrequency);
+    mixMonitor.Start(bytesPerSecond);
+    Mix_SetPostMix(&USBAudioManager::postMix, this);
+    return true;
+}
+
+// Start from the library index when there is one; the drive is checked
+// against it in the background and Update() picks up any changes.
+// Without an index, walk the drive in the background and start as soon
+// as the first folder with music has been read; Update() adds the rest.
+bool USBAudioManager::loadLibrary(const std::string& mountPath) {
+    std::string indexPath = LibraryIndex::DefaultPath();
+    LibraryIndex index;
+    if (index.Open(indexPath) && loadIndexedPlaylist(index, mountPath)) {
+        printf("Loaded %zu track(s) from library index %s (%zu KB in memory).\n",
+               playlist.size(), indexPath.c_str(), library.GetMemoryUsage() / 1024);
+        index.Close();
+        rescanThread = std::thread(&USBAudioManager::rescanLibrary, this, mountPath, indexPath, false);
+        return true;
     }
-    printf("Found %zu MP3 file(s) on USB drive.\n", playlist.size());
-    // Shuffle the playlist.
+    rescanThread = std::thread(&USBAudioManager::rescanLibrary, this, mountPath, indexPath, true);
     {
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(playlist.begin(), playlist.end(), g);
-        currentTrackIndex = 0;
+        std::unique_lock<std::mutex> lock(rescanMutex);
+        rescanCondition.wait(lock, [this] {
+            return !scannedTracks.empty() || scanFinished || initCancel.load();
+        });
+        addTracks(scannedTracks);
+        scannedTracks.clear();
+        rescanReady.store(false, std::memory_order_relaxed);
     }
-    // Load first trak
-    loadCurrentTrack();
+    if (playlist.empty()) {
+        std::cerr << "No MP3 files found on USB drive.\n";
+        return false;
+    }
+    printf("Found %zu MP3 file(s) on USB drive, still scanning.\n", playlist.size());
     return true;
 }
 
+void USBAudioManager::setInitStage(UsbInitStage stage) {
+    initVersion.store(NextPlaybackVersion(), std::memory_order_relaxed);
+    initStage.store(stage, std::memory_order_release);
+}
+
+void USBAudioManager::failInitialization(const char* message) {
+    if (initCancel.load())
+        return;
+    initError = message;
+    setInitStage(UsbInitStage::Failed);
+    onMusicFinished();
+}
+
+// Called from Update() once initThread is done.
+void USBAudioManager::finishInitialization() {
+    if (initThread.joinable())
+        initThread.join();
+    if (GetInitStage() != UsbInitStage::Ready)
+        return;
+    initialized = true;
+    libraryVersion = NextPlaybackVersion();
+    SetVolume(baseVolume);
+    loadCurrentTrack();
+    if (playRequested)
+        Play();
+}
+
+void USBAudioManager::stopInitialization() {
+    if (initThread.joinable()) {
+        {
+            // Under the lock, so loadLibrary()'s wait cannot miss it.
+            std::lock_guard<std::mutex> lock(rescanMutex);
+            initCancel.store(true);
+            preloadCancel.store(true);
+        }
+        rescanCondition.notify_all();
+        initThread.join();
+        initCancel.store(false);
+        preloadCancel.store(false);
+    }
+    initialized = false;
+}
+
 void USBAudioManager::Shutdown() {
+    stopInitialization();
+    // Keeps Update() from picking up a finished start-up again.
+    initError = "USB audio stopped";
+    setInitStage(UsbInitStage::Failed);
+    stopRescan();
+    Mix_HookMusicFinished(nullptr);
+    Mix_SetPostMix(nullptr, nullptr);
+    musicRunning.store(false);
+    discardPreload();
     unloadCurrentTrack();
+    if (trackCache.IsEnabled())
+        trackCache.PrintStats();
+    if (outputBytesPerSecond.load() > 0.0) {
+        printf("Audio: %llu period(s) mixed, %llu late.\n", GetMixedPeriods(), GetLatePeriods());
+        outputBytesPerSecond.store(0.0);
+    }
     Mix_CloseAudio();
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 }
 
 void USBAudioManager::Play() {
+    if (!initialized) {
+        playRequested = true;
+        return;
+    }
     if (playlist.empty()) {
         std::cerr << "Playlist is empty.\n";
         return;
@@ -149,16 +454,34 @@ void USBAudioManager::Play() {
     if (currentMusic == nullptr) {
         loadCurrentTrack();
     }
+    // Skip stale entries rather than stay silent (see MAX_SKIPPED_TRACKS).
+    for (size_t skipped = 0; currentMusic == nullptr && skipped < MAX_SKIPPED_TRACKS &&
+                             skipped + 1 < playlist.size(); skipped++) {
+        currentTrackIndex = (currentTrackIndex + 1) % playlist.size();
+        loadCurrentTrack();
+    }
+    if (currentMusic == nullptr) {
+        // Update() would otherwise keep retrying on every frame.
+        std::cerr << "No playable track found; stopping.\n";
+        musicRunning.store(false);
+        state = PlaybackState::Stopped;
+        return;
+    }
+    musicRunning.store(false);
+    mixedBytes.store(0);
     if (Mix_PlayMusic(currentMusic, 0) == -1) {
         std::cerr << "Error playing music: " << Mix_GetError() << "\n";
         return;
     }
+    musicRunning.store(true);
     state = PlaybackState::Playing;
-    playbackPosition = 0.0f;
+    startPreload();
 }
 
 void USBAudioManager::Pause() {
+    playRequested = false;
     if (state == PlaybackState::Playing) {
+        musicRunning.store(false);
         Mix_PauseMusic();
         state = PlaybackState::Paused;
     }
@@ -167,11 +490,14 @@ void USBAudioManager::Pause() {
 void USBAudioManager::Resume() {
     if (state == PlaybackState::Paused) {
         Mix_ResumeMusic();
+        musicRunning.store(true);
         state = PlaybackState::Playing;
     }
 }
 
 void USBAudioManager::NextTrack() {
+    if (!initialized)
+        return;
     unloadCurrentTrack();
     currentTrackIndex = (currentTrackIndex + 1) % playlist.size();
     loadCurrentTrack();
@@ -179,6 +505,8 @@ void USBAudioManager::NextTrack() {
 }
 
 void USBAudioManager::PreviousTrack() {
+    if (!initialized)
+        return;
     unloadCurrentTrack();
     if (currentTrackIndex == 0)
         currentTrackIndex = playlist.size() - 1;
@@ -188,10 +516,26 @@ void USBAudioManager::PreviousTrack() {
     Play();
 }
 
+bool USBAudioManager::PlayTrack(uint32_t track) {
+    if (!initialized)
+        return false;
+    auto it = std::find(playlist.begin(), playlist.end(), track);
+    if (it == playlist.end())
+        return false;
+    unloadCurrentTrack();
+    currentTrackIndex = static_cast<int>(it - playlist.begin());
+    loadCurrentTrack();
+    Play();
+    return true;
+}
+
 // Updated SetVolume: The UI uses baseVolume (full range), while effective volume = baseVolume * gainFactor.
 void USBAudioManager::SetVolume(int vol) {
     baseVolume = std::clamp(vol, 0, MIX_MAX_VOLUME);
-    int effectiveVolume = static_cast<int>(baseVolume * gainFactor);
+    // Applied by finishInitialization() once the audio device is open.
+    if (!initialized)
+        return;
+    int effectiveVolume = static_cast<int>(baseVolume * gainFactor * currentTrackGain());
     if (effectiveVolume > MIX_MAX_VOLUME)
         effectiveVolume = MIX_MAX_VOLUME;
     Mix_VolumeMusic(effectiveVolume);
@@ -206,9 +550,19 @@ PlaybackState USBAudioManager::GetState() const {
     return state;
 }
 
-void USBAudioManager::Update(float delta_time) {
+// The position comes from the mixer (see postMix()), so delta_time is not
+// needed here.
+void USBAudioManager::Update(float /*delta_time*/) {
+    if (!initialized) {
+        UsbInitStage stage = GetInitStage();
+        if (stage == UsbInitStage::Ready || stage == UsbInitStage::Failed)
+            finishInitialization();
+        if (!initialized)
+            return;
+    }
+    if (rescanReady.load(std::memory_order_acquire))
+        adoptRescannedPlaylist();
     if (state == PlaybackState::Playing) {
-        playbackPosition += delta_time;
         // If music has finished playing, automatically move to the next track
         if (!Mix_PlayingMusic()) {
             NextTrack();
@@ -218,11 +572,11 @@ void USBAudioManager::Update(float delta_time) {
 
 float USBAudioManager::GetPlaybackFraction() const {
     float duration = GetCurrentTrackDuration();
-    return (duration > 0.0f) ? (playbackPosition / duration) : 0.0f;
+    return (duration > 0.0f) ? std::min(GetCurrentPlaybackPosition() / duration, 1.0f) : 0.0f;
 }
 
 std::string USBAudioManager::GetTimeRemaining() const {
-    float remaining = GetCurrentTrackDuration() - playbackPosition;
+    float remaining = GetCurrentTrackDuration() - GetCurrentPlaybackPosition();
     if (remaining < 0.0f)
         remaining = 0.0f;
     int minutes = static_cast<int>(remaining) / 60;
@@ -233,25 +587,46 @@ std::string USBAudioManager::GetTimeRemaining() const {
 }
 
 std::string USBAudioManager::GetCurrentTrackTitle() const {
+    if (!initialized) {
+        switch (GetInitStage()) {
+        case UsbInitStage::WaitingForMount:   return "Waiting for USB drive";
+        case UsbInitStage::OpeningAudio:      return "Opening audio";
+        case UsbInitStage::LoadingLibrary:    return "Reading library";
+        case UsbInitStage::PrimingFirstTrack:
+        case UsbInitStage::Ready:             return "Loading first track";
+        case UsbInitStage::Failed:            return initError;
+        }
+    }
     if (playlist.empty())
         return "Unknown Track";
-    return playlist[currentTrackIndex].title;
+    return std::string(library.GetTitle(playlist[currentTrackIndex]));
 }
 
 std::string USBAudioManager::GetCurrentTrackArtist() const {
+    if (!initialized)
+        return "USB";
     if (playlist.empty())
         return "Unknown Artist";
-    return playlist[currentTrackIndex].artist;
+    return std::string(library.GetArtist(playlist[currentTrackIndex]));
 }
 
 float USBAudioManager::GetCurrentTrackDuration() const {
-    if (playlist.empty())
+    if (!initialized || playlist.empty())
         return 0.0f;
-    return playlist[currentTrackIndex].duration;
+    return library.Get(playlist[currentTrackIndex]).duration;
 }
 
 float USBAudioManager::GetCurrentPlaybackPosition() const {
-    return playbackPosition;
+    double bytesPerSecond = outputBytesPerSecond.load(std::memory_order_relaxed);
+    if (bytesPerSecond <= 0.0)
+        return 0.0f;
+    return static_cast<float>(mixedBytes.load(std::memory_order_relaxed) / bytesPerSecond);
+}
+
+unsigned long long USBAudioManager::GetMetadataVersion() const {
+    if (!initialized)
+        return initVersion.load(std::memory_order_relaxed);
+    return metadataVersion;
 }
 
 // New methods for gain adjustment to match bt volume
@@ -265,45 +640,365 @@ float USBAudioManager::GetGain() const {
     return gainFactor;
 }
 
+void USBAudioManager::SetExtensions(const std::vector<std::string>& extensions) {
+    scanner.SetExtensions(extensions);
+}
+
 // -----------------------------------------------------------------------------
 // Private Helper Functions
 // -----------------------------------------------------------------------------
-bool USBAudioManager::scanUSBDirectory() {
-    std::string mountPath = getUSBMountPath();
-    DIR* dir = opendir(mountPath.c_str());
-    if (!dir) {
+bool USBAudioManager::scanUSBDirectory(const std::string& mountPath, const LibraryIndex* previous,
+                                       std::vector<TrackInfo>& tracks, bool& changed, bool feedPlaylist) {
+    // Runs on the scanner's worker threads, one directory at a time.
+    std::mutex tracksMutex;
+    std::atomic<size_t> reused(0);
+    std::atomic<bool> parsed(false);
+    auto onBatch = [&](std::vector<TrackInfo>& batch) {
+        Id3Reader tags;
+        for (TrackInfo& info : batch) {
+            std::string_view relative = std::string_view(info.filePath).substr(mountPath.size() + 1);
+            LibraryIndex::Entry known;
+            if (previous && previous->Find(relative, known) &&
+                known.mtime == info.mtime && known.size == info.size) {
+                info.artist = std::string(known.artist);
+                info.title = std::string(known.title);
+                info.duration = known.duration;
+                info.loudness = known.loudness;
+                reused.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                float fileDuration = 0.0f;
+                // Parse artist, title, and duration from the filename 
+                std::string filename = info.filePath.substr(info.filePath.find_last_of('/') + 1);
+                parseFilename(filename, info.artist, info.title, fileDuration);
+                // Tags win over the filename; only the fields a tag has
+                // are copied out of the mapping.
+                if (isMp3(filename) && tags.Open(info.filePath)) {
+                    if (!tags.GetTitle().empty())
+                        info.title = std::string(tags.GetTitle());
+                    if (!tags.GetArtist().empty())
+                        info.artist = std::string(tags.GetArtist());
+                    tags.Close();
+                }
+                // The MP3 headers give the exact length; the filename's
+                // "XmYYs" is only a fallback. Cached in the index with the
+                // file's mtime and size.
+                float headerDuration = 0.0f;
+                if (isMp3(filename) && ProbeMp3Duration(info.filePath, headerDuration))
+                    fileDuration = headerDuration;
+                info.duration = fileDuration; // duration in seconds
+                parsed.store(true, std::memory_order_relaxed);
+            }
+        }
+        if (feedPlaylist) {
+            std::lock_guard<std::mutex> lock(rescanMutex);
+            scannedTracks.insert(scannedTracks.end(), batch.begin(), batch.end());
+            rescanReady.store(true, std::memory_order_release);
+            rescanCondition.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(tracksMutex);
+        tracks.insert(tracks.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    };
+
+    LibraryScanner::Stats stats;
+    if (!scanner.Run(mountPath, onBatch, &rescanCancel, &stats)) {
         std::cerr << "Failed to open USB directory: " << mountPath << "\n";
         return false;
     }
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        std::string filename = entry->d_name;
-        if (filename.length() > 4 && filename.substr(filename.length() - 4) == ".mp3") {
-            std::string fullPath = mountPath + "/" + filename;
-            TrackInfo info;
-            info.filePath = fullPath;
-            float fileDuration = 0.0f;
-            // Parse artist, title, and duration from the filename 
-            parseFilename(filename, info.artist, info.title, fileDuration);
-            info.duration = fileDuration; // duration in seconds
-            playlist.push_back(info);
-        }
+    printf("Scanned %zu file(s) in %zu folder(s) on USB drive in %.2fs (%.0f files/s), %zu match.\n",
+           stats.files, stats.directories, stats.seconds, stats.FilesPerSecond(), stats.matched);
+    // Anything in the index that was not seen again has been removed.
+    changed = parsed.load() || !previous || reused.load() != previous->GetCount();
+    return !tracks.empty();
+}
+
+bool USBAudioManager::loadIndexedPlaylist(const LibraryIndex& index, const std::string& mountPath) {
+    library.Clear();
+    playlist.clear();
+    library.Reserve(index.GetCount());
+    playlist.reserve(index.GetCount());
+    std::string path = mountPath + "/";
+    for (size_t i = 0; i < index.GetCount(); i++) {
+        LibraryIndex::Entry entry = index.GetEntry(i);
+        path.resize(mountPath.size() + 1);
+        path.append(entry.path);
+        playlist.push_back(library.Add(path, entry.artist, entry.title, entry.duration,
+                                       entry.loudness, entry.mtime, entry.size));
     }
-    closedir(dir);
     return !playlist.empty();
 }
 
+void USBAudioManager::addTracks(const std::vector<TrackInfo>& tracks) {
+    library.Reserve(library.GetCount() + tracks.size());
+    playlist.reserve(playlist.size() + tracks.size());
+    for (const TrackInfo& track : tracks)
+        playlist.push_back(library.Add(track));
+}
+
+void USBAudioManager::shufflePlaylist() {
+    std::random_device rd;
+    std::mt19937 g(rd());
+    std::shuffle(playlist.begin(), playlist.end(), g);
+    currentTrackIndex = 0;
+}
+
+// Runs on rescanThread. Only touches its arguments and the members guarded
+// by rescanMutex, so playback can go on from the playlist in the meantime.
+void USBAudioManager::rescanLibrary(std::string mountPath, std::string indexPath, bool feedPlaylist) {
+    LibraryIndex index;
+    if (!feedPlaylist)
+        index.Open(indexPath);
+    std::vector<TrackInfo> tracks;
+    bool changed = false;
+    bool found = scanUSBDirectory(mountPath, index.IsOpen() ? &index : nullptr, tracks, changed, feedPlaylist);
+    index.Close();
+    bool update = found && changed && !rescanCancel.load(std::memory_order_relaxed);
+    if (update) {
+        LibraryIndex::Write(indexPath, mountPath, tracks);
+        printf("Library index updated: %zu MP3 file(s) on USB drive.\n", tracks.size());
+    }
+    std::unique_lock<std::mutex> lock(rescanMutex);
+    // When feeding the playlist, Update() has already seen every track.
+    if (update && !feedPlaylist) {
+        rescannedPlaylist = tracks;
+        rescanReady.store(true, std::memory_order_release);
+    }
+    scanFinished = true;
+    rescanCondition.notify_all();
+    lock.unlock();
+    if (found && loudnessEnabled() && !rescanCancel.load(std::memory_order_relaxed))
+        analyzeLoudness(mountPath, indexPath, tracks);
+}
+
+// Swaps in a rescanned playlist without interrupting the current track: it
+// is kept at the front of the newly shuffled order. Tracks found by a scan
+// that feeds the playlist are shuffled into the part not yet played.
+void USBAudioManager::adoptRescannedPlaylist() {
+    std::vector<TrackInfo> tracks;
+    std::vector<TrackInfo> added;
+    std::vector<std::pair<std::string, float>> measured;
+    {
+        std::lock_guard<std::mutex> lock(rescanMutex);
+        tracks.swap(rescannedPlaylist);
+        added.swap(scannedTracks);
+        measured.swap(measuredLoudness);
+        rescanReady.store(false, std::memory_order_relaxed);
+    }
+    if (!tracks.empty()) {
+        TrackInfo current;
+        bool hasCurrent = !playlist.empty();
+        if (hasCurrent)
+            current = library.GetInfo(playlist[currentTrackIndex]);
+        library.Clear();
+        playlist.clear();
+        addTracks(tracks);
+        shufflePlaylist();
+        if (hasCurrent) {
+            uint32_t index = 0;
+            if (library.Find(current.filePath, index))
+                std::iter_swap(playlist.begin(), std::find(playlist.begin(), playlist.end(), index));
+            else
+                playlist.insert(playlist.begin(), library.Add(current));
+        }
+        libraryVersion = NextPlaybackVersion();
+        metadataVersion = NextPlaybackVersion();
+    }
+    if (!added.empty()) {
+        std::random_device rd;
+        std::mt19937 g(rd());
+        size_t first = playlist.size();
+        addTracks(added);
+        for (size_t i = first; i < playlist.size(); i++) {
+            std::uniform_int_distribution<size_t> slot(currentTrackIndex + 1, i);
+            std::swap(playlist[i], playlist[slot(g)]);
+        }
+    }
+    // Takes effect when each track is next loaded.
+    if (!measured.empty())
+        library.UpdateLoudness(measured);
+    // The track after the current one may have changed.
+    if (state != PlaybackState::Stopped)
+        startPreload();
+}
+
+void USBAudioManager::stopRescan() {
+    if (rescanThread.joinable()) {
+        rescanCancel.store(true, std::memory_order_relaxed);
+        rescanThread.join();
+    }
+    rescanCancel.store(false, std::memory_order_relaxed);
+    rescanReady.store(false, std::memory_order_relaxed);
+    rescannedPlaylist.clear();
+    scannedTracks.clear();
+    measuredLoudness.clear();
+    scanFinished = false;
+}
+
+// Runs on rescanThread once the scan is done. Each track is decoded in
+// full, so cancelling waits for at most the track being measured. Tracks
+// whose decoded audio would exceed LOUDNESS_MAX_DECODE_BYTES are not
+// decoded at all; they, and tracks that fail to decode, are marked
+// LOUDNESS_UNMEASURABLE (played at unity gain) and are not tried again
+// until the file changes and a rescan resets them to 0.
+void USBAudioManager::analyzeLoudness(const std::string& mountPath, const std::string& indexPath,
+                                      std::vector<TrackInfo>& tracks) {
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < tracks.size(); i++) {
+        if (tracks[i].loudness == 0.0f)
+            pending.push_back(i);
+    }
+    if (pending.empty())
+        return;
+    int rate = 0;
+    Uint16 format = 0;
+    int channels = 0;
+    if (!Mix_QuerySpec(&rate, &format, &channels) || format != AUDIO_S16SYS ||
+        !LoudnessMeter(rate, channels).IsValid()) {
+        printf("Loudness: output format not supported, tracks not analysed.\n");
+        return;
+    }
+    lowerThreadPriority();
+    loudnessDone.store(0, std::memory_order_relaxed);
+    loudnessTotal.store(pending.size(), std::memory_order_relaxed);
+    printf("Loudness: analysing %zu track(s) in the background.\n", pending.size());
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastCheckpoint = start;
+    double bytesPerSecond = static_cast<double>(rate) * channels * sizeof(Sint16);
+    double audioSeconds = 0.0;
+    size_t measured = 0;
+    size_t skipped = 0;
+    bool unsaved = false;
+    std::vector<std::pair<std::string, float>> batch;
+    for (size_t n = 0; n < pending.size() && !rescanCancel.load(std::memory_order_relaxed); n++) {
+        TrackInfo& track = tracks[pending[n]];
+        double length = track.duration > 0.0f ? track.duration : track.size * 8.0 / LOUDNESS_ASSUMED_BITRATE;
+        float lufs = 0.0f;
+        double seconds = 0.0;
+        if (length * bytesPerSecond > LOUDNESS_MAX_DECODE_BYTES) {
+            track.loudness = LOUDNESS_UNMEASURABLE;
+            skipped++;
+        } else if (measureLoudness(track.filePath, rate, channels, lufs, seconds) && lufs != 0.0f) {
+            track.loudness = lufs;
+            audioSeconds += seconds;
+            measured++;
+        } else if (!rescanCancel.load(std::memory_order_relaxed)) {
+            // Not retried on later starts unless the file changes (a
+            // rescan then parses it afresh, with loudness 0).
+            track.loudness = LOUDNESS_UNMEASURABLE;
+        } else {
+            break;
+        }
+        batch.emplace_back(track.filePath, track.loudness);
+        unsaved = true;
+        loudnessDone.store(n + 1, std::memory_order_relaxed);
+        if (batch.size() < LOUDNESS_BATCH && n + 1 < pending.size())
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(rescanMutex);
+            measuredLoudness.insert(measuredLoudness.end(), batch.begin(), batch.end());
+            rescanReady.store(true, std::memory_order_release);
+        }
+        batch.clear();
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        printf("Loudness: %zu/%zu track(s) analysed, %.1f tracks/min, %.1fx real time.\n",
+               n + 1, pending.size(), elapsed > 0.0 ? 60.0 * (n + 1) / elapsed : 0.0,
+               elapsed > 0.0 ? audioSeconds / elapsed : 0.0);
+        // The head unit can lose power at any time; keep what is done.
+        if (now - lastCheckpoint >= LOUDNESS_CHECKPOINT) {
+            LibraryIndex::Write(indexPath, mountPath, tracks);
+            lastCheckpoint = now;
+            unsaved = false;
+        }
+    }
+    // Finished, or cancelled: either way worth saving.
+    if (unsaved)
+        LibraryIndex::Write(indexPath, mountPath, tracks);
+    printf("Loudness: measured %zu of %zu track(s), %zu too long to decode.\n",
+           measured, pending.size(), skipped);
+}
+
+// Gain that brings the current track to LOUDNESS_TARGET_LUFS; 1 for a
+// track not analysed yet.
+float USBAudioManager::currentTrackGain() const {
+    if (playlist.empty() || !loudnessEnabled())
+        return 1.0f;
+    float loudness = library.Get(playlist[currentTrackIndex]).loudness;
+    if (loudness == 0.0f || loudness == LOUDNESS_UNMEASURABLE)
+        return 1.0f;
+    float gain = std::pow(10.0f, (LOUDNESS_TARGET_LUFS - loudness) / 20.0f);
+    return std::clamp(gain, MIN_TRACK_GAIN, MAX_TRACK_GAIN);
+}
+
+void USBAudioManager::GetLoudnessProgress(size_t& done, size_t& total) const {
+    done = loudnessDone.load(std::memory_order_relaxed);
+    total = loudnessTotal.load(std::memory_order_relaxed);
+}
+
+const TrackStore* USBAudioManager::GetLibrary() const {
+    return initialized ? &library : nullptr;
+}
+
+unsigned long long USBAudioManager::GetLibraryVersion() const {
+    return initialized ? libraryVersion : 0;
+}
+
+// Runs on the audio thread after every mixed chunk. Counting what was sent
+// to the device keeps the position right however rarely the UI thread
+// wakes up. Lags the decoder by at most one chunk.
+void USBAudioManager::postMix(void* udata, Uint8* /*stream*/, int length) {
+    USBAudioManager* manager = static_cast<USBAudioManager*>(udata);
+    if (manager->musicRunning.load(std::memory_order_relaxed))
+        manager->mixedBytes.fetch_add(static_cast<unsigned long long>(length), std::memory_order_relaxed);
+    manager->mixMonitor.OnMixed(length);
+}
+
+unsigned long long USBAudioManager::GetMixedPeriods() const {
+    return mixMonitor.GetMixedPeriods();
+}
+
+unsigned long long USBAudioManager::GetLatePeriods() const {
+    return mixMonitor.GetLatePeriods();
+}
+
+// Runs on the UI thread, which tags each underrun with the current track.
+bool USBAudioManager::PollUnderrun(AudioUnderrun& underrun) {
+    // The init thread resets the monitor when it opens the device.
+    if (!initialized || !mixMonitor.PollUnderrun(underrun.time, underrun.lateMs))
+        return false;
+    underrun.track = GetCurrentTrackArtist() + " - " + GetCurrentTrackTitle();
+    return true;
+}
+
 // Loads the current track into memory using SDL_RWops
 void USBAudioManager::loadCurrentTrack() {
+    metadataVersion = NextPlaybackVersion();
     if (playlist.empty())
         return;
     unloadCurrentTrack();
-    const TrackInfo &track = playlist[currentTrackIndex];
-    
-    // open the file in binary mode
-    SDL_RWops* rw = SDL_RWFromFile(track.filePath.c_str(), "rb");
+    // Each track plays at its own gain (see currentTrackGain()).
+    if (initialized)
+        SetVolume(baseVolume);
+    std::string path = library.GetPath(playlist[currentTrackIndex]);
+    // Usually the preload has already opened it.
+    if (takePreload(path))
+        return;
+
+    // Nothing is read whole here on the UI thread: play from RAM if the
+    // track cache has the file, otherwise stream it and have the preload
+    // thread cache it for next time.
+    SDL_RWops* rw = nullptr;
+    currentData = trackCache.Find(path);
+    if (currentData) {
+        rw = SDL_RWFromConstMem(currentData->data(), static_cast<int>(currentData->size()));
+    } else {
+        // open the file in binary mode
+        rw = SDL_RWFromFile(path.c_str(), "rb");
+        if (trackCache.IsEnabled())
+            cacheFillPath = path;
+    }
     if (!rw) {
-        std::cerr << "Failed to open file " << track.filePath << "\n";
+        std::cerr << "Failed to open file " << path << "\n";
         return;
     }
     // Load the music from the RWops.
@@ -320,4 +1015,85 @@ void USBAudioManager::unloadCurrentTrack() {
         Mix_FreeMusic(currentMusic);
         currentMusic = nullptr;
     }
+    currentData.reset();
+}
+
+void USBAudioManager::startPreload() {
+    if (playlist.size() < 2)
+        return;
+    std::string next = library.GetPath(playlist[(currentTrackIndex + 1) % playlist.size()]);
+    if (next == preloadPath)
+        return;
+    discardPreload();
+    preloadPath = next;
+    std::string fill;
+    fill.swap(cacheFillPath);
+    preloadDone.store(false, std::memory_order_relaxed);
+    preloadThread = std::thread([this, next, fill] {
+        // A current track that missed the cache is read in first.
+        if (!fill.empty())
+            trackCache.Load(fill, &preloadCancel);
+        preloadTrack(next);
+        preloadDone.store(true, std::memory_order_release);
+    });
+}
+
+// Runs on preloadThread. Reads the whole file (the drive is the slow part),
+// through the track cache, and lets SDL_mixer open the decoder on the
+// in-memory copy. A file the cache turns down as too large is opened for
+// streaming instead, which still keeps the open off the UI thread.
+void USBAudioManager::preloadTrack(std::string path) {
+    TrackCache::Buffer data = trackCache.Load(path, &preloadCancel);
+    if (preloadCancel.load(std::memory_order_relaxed))
+        return;
+    SDL_RWops* rw = data ? SDL_RWFromConstMem(data->data(), static_cast<int>(data->size()))
+                         : SDL_RWFromFile(path.c_str(), "rb");
+    if (!rw)
+        return;
+    Mix_Music* music = Mix_LoadMUS_RW(rw, 1);
+    if (!music) {
+        std::cerr << "Failed to preload track " << path << ": " << Mix_GetError() << "\n";
+        return;
+    }
+    preloadData = std::move(data);
+    preloadMusic = music;
+}
+
+// Hands the preloaded music to currentMusic if it is the track wanted and
+// has finished opening. One still being read is cancelled rather than
+// waited for.
+bool USBAudioManager::takePreload(const std::string& path) {
+    if (path != preloadPath) {
+        discardPreload();
+        return false;
+    }
+    if (preloadThread.joinable()) {
+        if (!preloadDone.load(std::memory_order_acquire)) {
+            discardPreload();
+            return false;
+        }
+        preloadThread.join();
+    }
+    bool ready = preloadMusic != nullptr;
+    if (ready) {
+        currentMusic = preloadMusic;
+        currentData.swap(preloadData);
+        preloadMusic = nullptr;
+    }
+    discardPreload();
+    return ready;
+}
+
+void USBAudioManager::discardPreload() {
+    if (preloadThread.joinable()) {
+        preloadCancel.store(true, std::memory_order_relaxed);
+        preloadThread.join();
+        preloadCancel.store(false, std::memory_order_relaxed);
+    }
+    if (preloadMusic) {
+        Mix_FreeMusic(preloadMusic);
+        preloadMusic = nullptr;
+    }
+    preloadData.reset();
+    preloadPath.clear();
 }
\ No newline at end of file
@@ -2,16 +2,30 @@
 #define USB_AUDIO_MANAGER_H
 
 #include "IAudioManager.h"
+#include "TrackInfo.h"
+#include "LibraryScanner.h"
+#include "TrackCache.h"
+#include "TrackStore.h"
+#include "MixMonitor.h"
 #include <vector>
 #include <string>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <SDL_mixer.h>   // For Mix_Music definition
 
-// Structure to hold track metadata.
-struct TrackInfo {
-    std::string filePath;
-    std::string artist;
-    std::string title;
-    float duration; // in seconds
+class LibraryIndex;
+
+// Steps of USBAudioManager's background start-up, in order.
+enum class UsbInitStage {
+    WaitingForMount,    // Until the drive is mounted and readable
+    OpeningAudio,
+    LoadingLibrary,     // Index, or the first folder of a cold scan
+    PrimingFirstTrack,  // Reading and opening the first track
+    Ready,
+    Failed
 };
 
 class USBAudioManager : public IAudioManager {
@@ -42,28 +56,146 @@ public:
     virtual std::string GetCurrentTrackArtist() const override;
     virtual float GetCurrentTrackDuration() const override;
     virtual float GetCurrentPlaybackPosition() const override;
+    virtual unsigned long long GetMetadataVersion() const override;
 
     // New methods for gain adjustment.
     void SetGain(float factor);
     float GetGain() const;
 
+    // Initialize() only checks for the drive and returns; the rest runs on a
+    // background thread while the UI is already drawing. Until the stage
+    // is Ready the title reports progress, and Play() is remembered and
+    // carried out once the first track is primed.
+    UsbInitStage GetInitStage() const;
+
+    // Mixer callbacks so far, and how many of them came too late to keep
+    // the device fed (underruns). For sizing RADI0_AUDIO_PERIOD per board.
+    unsigned long long GetMixedPeriods() const;
+    unsigned long long GetLatePeriods() const;
+    virtual bool PollUnderrun(AudioUnderrun& underrun) override;
+
+    // Background loudness analysis: tracks measured so far out of those
+    // that were missing a loudness when it started.
+    void GetLoudnessProgress(size_t& done, size_t& total) const;
+
+    // The library, for browsing, while initialized (nullptr otherwise).
+    // The version changes whenever the library is replaced rather than
+    // added to, so indices into it from an older version are void.
+    const TrackStore* GetLibrary() const;
+    unsigned long long GetLibraryVersion() const;
+    // Plays a track picked from the library, as an index into it.
+    bool PlayTrack(uint32_t track);
+
+    // Where the "Mustick" drive is mounted for the current user.
+    static std::string GetMountPath();
+
+    // File extensions picked up by the library scan (default ".mp3").
+    void SetExtensions(const std::vector<std::string>& extensions);
+
+    // Optional RAM cache of whole track files (see TrackCache).
+    TrackCache& GetTrackCache() { return trackCache; }
+
 private:
-    bool scanUSBDirectory();
+    void initializeAsync(std::string mountPath);
+    bool waitForMount(const std::string& mountPath);
+    bool openAudio();
+    bool loadLibrary(const std::string& mountPath);
+    void setInitStage(UsbInitStage stage);
+    void failInitialization(const char* message);
+    void finishInitialization();
+    void stopInitialization();
+
+    // Lists the music files anywhere under mountPath into 'tracks'. Files
+    // whose mtime and size match their entry in 'previous' reuse it instead
+    // of being parsed; 'changed' reports whether the result differs from
+    // 'previous'. With feedPlaylist, every directory's tracks are also
+    // queued for Update() to add to the playlist as the walk goes on.
+    bool scanUSBDirectory(const std::string& mountPath, const LibraryIndex* previous,
+                          std::vector<TrackInfo>& tracks, bool& changed, bool feedPlaylist);
+    bool loadIndexedPlaylist(const LibraryIndex& index, const std::string& mountPath);
+    // Appends tracks to the library, in order, at the end of the playlist.
+    void addTracks(const std::vector<TrackInfo>& tracks);
+    void shufflePlaylist();
+    // Background library scan (see Initialize()).
+    void rescanLibrary(std::string mountPath, std::string indexPath, bool feedPlaylist);
+    void adoptRescannedPlaylist();
+    // Measures the tracks without a loudness, after the rescan and on its
+    // thread, at idle priority. Results go to the index and, through
+    // measuredLoudness, to the playlist.
+    void analyzeLoudness(const std::string& mountPath, const std::string& indexPath,
+                         std::vector<TrackInfo>& tracks);
+    float currentTrackGain() const;
+    void stopRescan();
     void loadCurrentTrack();
     void unloadCurrentTrack();
-
-    std::vector<TrackInfo> playlist;
+    static void postMix(void* udata, Uint8* stream, int length);
+    // Opens the track after the current one on preloadThread, so the next
+    // track change is a handoff without file I/O on the render thread.
+    void startPreload();
+    void preloadTrack(std::string path);
+    bool takePreload(const std::string& path);
+    void discardPreload();
+
+    TrackStore library;
+    std::vector<uint32_t> playlist;   // Play order, as indices into library
+    unsigned long long libraryVersion;  // Bumped whenever the library is replaced
     int currentTrackIndex;
     PlaybackState state;
     int volume; // Current effective volume (0-128)
-    float playbackPosition; // in seconds
+    // Playback position, counted by the post-mix hook on the audio thread
+    // in bytes of output actually mixed while the music runs.
+    std::atomic<unsigned long long> mixedBytes;
+    std::atomic<bool> musicRunning;
+    // Set on the init thread when the device opens, read by the UI thread
+    // (position) while start-up may still be running.
+    std::atomic<double> outputBytesPerSecond;
+    MixMonitor mixMonitor;   // Underruns; polled on the UI thread
+    unsigned long long metadataVersion; // Bumped whenever a track is loaded
 
     // SDL_mixer music pointer
     Mix_Music* currentMusic;
+    TrackCache::Buffer currentData;   // File contents when currentMusic plays from memory
+    TrackCache trackCache;
+
+    // Preloaded next track. preloadData/preloadMusic belong to
+    // preloadThread until it has been joined.
+    std::thread preloadThread;
+    std::atomic<bool> preloadCancel;
+    std::atomic<bool> preloadDone;    // preloadThread has nothing left to do
+    std::string preloadPath;
+    TrackCache::Buffer preloadData;
+    Mix_Music* preloadMusic;
+    std::string cacheFillPath;   // Streamed on a cache miss; the next preload caches it
 
     // New private members for volume gain control.
     int baseVolume;      // The user-set base volume (before gain)
     float gainFactor;    // Multiplier for adjusting the effective volume
+
+    // Start-up. Until initThread has been joined it owns the playlist, the
+    // preload slot and the audio device; the UI thread only reads the
+    // atomics (and initError once the stage is Failed).
+    std::thread initThread;
+    std::atomic<UsbInitStage> initStage;
+    std::atomic<unsigned long long> initVersion;   // Metadata version of the progress text
+    std::atomic<bool> initCancel;
+    std::string initError;
+    bool initialized;      // Set on the UI thread once the thread is joined and Ready
+    bool playRequested;    // Play() was called before initialization finished
+
+    // Library scan running while playback starts from the index, or from
+    // the first tracks found when there is no index yet.
+    LibraryScanner scanner;
+    std::thread rescanThread;
+    std::mutex rescanMutex;
+    std::condition_variable rescanCondition;
+    std::vector<TrackInfo> rescannedPlaylist;   // Guarded by rescanMutex
+    std::vector<TrackInfo> scannedTracks;       // Guarded by rescanMutex
+    bool scanFinished;                          // Guarded by rescanMutex
+    std::vector<std::pair<std::string, float>> measuredLoudness;   // Guarded by rescanMutex
+    std::atomic<size_t> loudnessDone;
+    std::atomic<size_t> loudnessTotal;
+    std::atomic<bool> rescanReady;
+    std::atomic<bool> rescanCancel;
 };
 
 #endif // USB_AUDIO_MANAGER_H
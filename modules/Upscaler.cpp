@@ -0,0 +1,54 @@
+#include "Upscaler.h"
+#include <algorithm>
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+Upscaler::Upscaler()
+    : linearFilter(false)
+{
+}
+
+bool Upscaler::Initialize(int width, int height, bool linear_filter)
+{
+    linearFilter = linear_filter;
+    return target.Create(width, height, linear_filter);
+}
+
+void Upscaler::Cleanup()
+{
+    target.Destroy();
+}
+
+void Upscaler::BeginFrame()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, target.GetFramebuffer());
+    glViewport(0, 0, target.GetWidth(), target.GetHeight());
+}
+
+void Upscaler::Present(int window_width, int window_height)
+{
+    int width = target.GetWidth();
+    int height = target.GetHeight();
+    float scale = std::min(static_cast<float>(window_width) / width,
+                           static_cast<float>(window_height) / height);
+    int dst_width = static_cast<int>(width * scale);
+    int dst_height = static_cast<int>(height * scale);
+    int dst_x = (window_width - dst_width) / 2;
+    int dst_y = (window_height - dst_height) / 2;
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glViewport(0, 0, window_width, window_height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.GetFramebuffer());
+    glBlitFramebuffer(0, 0, width, height,
+                      dst_x, dst_y, dst_x + dst_width, dst_y + dst_height,
+                      GL_COLOR_BUFFER_BIT, linearFilter ? GL_LINEAR : GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,32 @@
+#ifndef UPSCALER_H
+#define UPSCALER_H
+
+#include "RenderTarget.h"
+
+// Renders the UI at a fixed internal resolution and scales it up to the
+// window, so the GPU fill cost no longer depends on the attached panel.
+// The image keeps its aspect ratio and is centered (letterboxed).
+class Upscaler {
+public:
+    Upscaler();
+
+    // Creates the internal render target. Returns false (and stays disabled)
+    // if the framebuffer cannot be created.
+    bool Initialize(int width, int height, bool linear_filter);
+    void Cleanup();
+
+    bool IsEnabled() const { return target.IsValid(); }
+    int GetWidth() const { return target.GetWidth(); }
+    int GetHeight() const { return target.GetHeight(); }
+
+    // Redirects rendering into the internal target.
+    void BeginFrame();
+    // Clears the window and blits the internal target onto it.
+    void Present(int window_width, int window_height);
+
+private:
+    RenderTarget target;
+    bool linearFilter;
+};
+
+#endif // UPSCALER_H
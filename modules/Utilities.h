@@ -3,6 +3,10 @@
 
 #include "imgui.h"
 
+// Artist and track text, on the main screen and in the library browser, is
+// drawn at this multiple of the default font size.
+constexpr float TEXT_FONT_SCALE = 1.6f;
+
 // Converts virtual coordinates to actual pixels using a unified scale and offsets.
 inline ImVec2 ToPixels(float x_virtual, float y_virtual, float scale, float offset_x, float offset_y)
 {